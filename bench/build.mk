@@ -0,0 +1,14 @@
+# Run all the benchmarks
+BENCHMARKS = \
+	$(BUILD)bench/dot \
+
+bench: $(BENCHMARKS)
+	for b in $(BENCHMARKS); do ./$$b; done
+
+#
+# --- Generate the benchmark programs ---
+#
+
+$(BUILD)bench/dot: bench/dot.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)bench"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ bench/dot.c -ldoag -lgmp -lm -lpthread
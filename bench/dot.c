@@ -0,0 +1,101 @@
+/* Throughput of randdag_to_dot compared to the previous implementation, which
+ * made one fprintf call per vertex and per edge. Also check that both produce
+ * the same output. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../includes/doag.h"
+#include <gmp.h>
+
+static void legacy_to_dot(FILE *fd, const randdag_t g, unsigned int flags) {
+  int i;
+
+  fprintf(fd, "digraph G {\n  rankdir = \"TB\"\n");
+  if (flags & RD_DOT_ORDERING) {
+    fprintf(fd, "  ordering = \"out\"\n");
+  }
+  fprintf(fd, "  edge [arrowhead=none, penwidth=2]\n");
+  if (!(flags & RD_DOT_LABELLED)) {
+    fprintf(fd, "  node [shape=circle, label=\"\", color=black, style=filled, "
+                "width=.5]\n");
+  }
+
+  for (i = 0; i < g.N; i++) {
+    int j;
+    const randdag_vertex u = g.v[i];
+
+    fprintf(fd, "  n%d", u.id);
+    if (flags & RD_DOT_LABELLED)
+      fprintf(fd, " [label=\"%d\"]", u.id);
+    fprintf(fd, "\n");
+    if (u.out_degree > 0) {
+      fprintf(fd, "  n%d -> {n%d", u.id, u.out_edges[0].id);
+      for (j = 1; j < u.out_degree; j++) {
+        fprintf(fd, ", n%d", u.out_edges[j].id);
+      }
+      fprintf(fd, "}\n");
+    }
+  }
+
+  fprintf(fd, "}\n");
+}
+
+/* Write g to a temporary file and return its content. */
+static char *render(int legacy, const randdag_t g, unsigned int flags,
+                    long *size, double *seconds) {
+  char *content;
+  clock_t t;
+  FILE *fd = tmpfile();
+
+  t = clock();
+  if (legacy)
+    legacy_to_dot(fd, g, flags);
+  else
+    randdag_to_dot(fd, g, flags);
+  fflush(fd);
+  *seconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+  *size = ftell(fd);
+  content = malloc(*size);
+  rewind(fd);
+  if (fread(content, 1, *size, fd) != (size_t)*size)
+    *size = -1;
+  fclose(fd);
+  return content;
+}
+
+int main(int argc, char *argv[]) {
+  int n, flags, error = 0;
+  gmp_randstate_t state;
+  randdag_t g;
+
+  n = (argc > 1) ? atoi(argv[1]) : 5000;
+  gmp_randinit_default(state);
+  gmp_randseed_ui(state, 0xdeadbeef);
+  g = doag_unif_n(state, n);
+
+  for (flags = 0; flags <= (RD_DOT_LABELLED | RD_DOT_ORDERING); flags++) {
+    long size_old, size_new;
+    double t_old, t_new;
+    char *old = render(1, g, flags, &size_old, &t_old);
+    char *new = render(0, g, flags, &size_new, &t_new);
+
+    printf("n=%d flags=%d: %ld bytes, fprintf %.3fs (%.0f MB/s), buffered "
+           "%.3fs (%.0f MB/s)\n",
+           n, flags, size_old, t_old, size_old / 1e6 / t_old, t_new,
+           size_new / 1e6 / t_new);
+    if (size_old != size_new || memcmp(old, new, size_old) != 0) {
+      fprintf(stderr, "[ERROR] the outputs differ for flags=%d\n", flags);
+      error = 1;
+    }
+    free(old);
+    free(new);
+  }
+
+  randdag_free(g);
+  gmp_randclear(state);
+  return error;
+}
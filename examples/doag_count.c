@@ -12,7 +12,7 @@
  * intermediate computations are stored in a table and can be reused in later
  * calls to the counting function.
  *
- * Compile with: utils.c -ldoag -lgmp
+ * Compile with: utils.c -ldoag -lgmp -lm -lpthread
  *
  * Example: running `doag_n.exe 10 30 1` from the command line will
  * print:
@@ -10,7 +10,7 @@
  * libdoag's doag_unif_n function.
  * The algorithm used in this function does not require any pre-processing.
  *
- * Compile with: utils.c -ldoag -lgmp
+ * Compile with: utils.c -ldoag -lgmp -lm -lpthread
  *
  * Example: running `doag_n.exe 10 > doag.dot` from the command line will
  * generate a uniform random DOAG with 10 vertices and store it to `doag.dot`
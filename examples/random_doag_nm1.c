@@ -10,13 +10,15 @@
  * bounded out-degree and exactly one source using libdoag's doag_unif_nmk
  * function.
  *
- * Compile with: utils.c -ldoag -lgmp
+ * Compile with: utils.c -ldoag -lgmp -lm -lpthread
  *
- * Example: running `random_doag_nm1.exe 100 150 2 > doag.dot` from the command
- * line will generate a uniform unary-binary random DOAG with 100 vertices, 150
- * edges, out-degree bounded by 2 and store it to `doag.dot` (in graphviz' dot
- * format). The result can be visualised the result by running `dot -Tpdf
- * doag.dot -o doag.pdf`.
+ * Example: running `random_doag_nm1.exe 100 150 1000` from the command line
+ * will generate 1000 uniform unary-binary random DOAGs with 100 vertices, 150
+ * edges, out-degree bounded by 2 and store them to the shard files `doag.0` to
+ * `doag.9` (in graphviz' dot format). Each line "shard offset size" of
+ * `doag.idx` gives the location of a graph, which can be extracted and
+ * visualised by running e.g. `tail -c +$((offset + 1)) doag.<shard> | head -c
+ * size | dot -Tpdf -o doag.pdf`.
  *
  * NB. utils.c contains the boilerplate command line parsing code for our
  * examples so that this file contains only the relevant part of the
@@ -26,12 +28,14 @@
 const char *usage_string =
     "USAGE: %s N M NB\nSamples NB DOAGs of size (N, M) "
     "with one source and out degree bounded by 2.\n"
-    "The NB graphs are stored in files named doag_0.dot, doag_1.dot, etc.\n";
+    "The NB graphs are stored in the shard files doag.0, doag.1, etc. (100 "
+    "graphs per shard)\nand their offsets in these files in doag.idx.\n";
 
 int main(int argc, char *argv[]) {
   int n, m, nb;
   gmp_randstate_t prng;
   randdag_t doag;
+  randdag_shards_t *shards;
   memo_t memo;
 
   /* Get the parameters from the command line */
@@ -45,32 +49,31 @@ int main(int argc, char *argv[]) {
   gmp_randinit_default(prng);
   gmp_randseed_ui(prng, 0xdeadbeef);
 
-  for (; nb > 0; nb--) {
-    char filename[32]; /* Large enough to be sure there is no overflow. */
-    FILE *fd;
+  /* Open the output files.
+   * The graphs are printed in dot format. Since the ordering of the nodes
+   * matters in DOAGs, the RD_DOT_ORDERING flag must be passed to tell graphviz
+   * to respect our ordering when printing the graph.
+   * Rather than opening one file per graph, we group them in shard files of
+   * 100 graphs each, written in the background while we keep sampling. */
+  shards = randdag_shards_open("doag", RD_FMT_DOT, RD_DOT_ORDERING, 0, 100);
+  if (shards == NULL) {
+    fprintf(stderr, "Error while opening file: doag.idx\n");
+    return 2;
+  }
 
+  for (; nb > 0; nb--) {
     /* Generate a uniform DOAG with n vertices. */
     doag = doag_unif_nmk(prng, memo, n, m, 1, 2);
-
-    /* Open the output file. */
-    sprintf(filename, "doag_%d.dot", nb);
-    if (!(fd = fopen(filename, "w"))) {
-      perror("fopen");
-      fprintf(stderr, "Error while opening file: %s:\n", filename);
-      return 2;
-    }
-
-    /* Print the graph in dot format to fd.
-     * Since the ordering of the nodes matters in DOAGs, the RD_DOT_ORDERING
-     * flag must be passed to tell graphviz to respect our ordering when
-     * printing the graph. */
-    randdag_to_dot(fd, doag, RD_DOT_ORDERING);
-
-    fclose(fd);
+    randdag_shards_write(shards, doag);
+    randdag_free(doag);
   }
 
   /* Do some cleanups. */
-  randdag_free(doag);
+  if (randdag_shards_close(shards) != 0) {
+    fprintf(stderr, "Error while writing the shard files\n");
+    return 2;
+  }
+  memo_free(memo);
   gmp_randclear(prng);
 
   return 0;
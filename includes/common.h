@@ -24,6 +24,12 @@ typedef struct {
   /** The array in which counting information is stored. Never manipulate this
    * directly. */
   mpz_t ***vals;
+  /* XXX. Machine-integer version of vals for small values of n, see
+   * src/common/small.h. Leave this undocumented. */
+  void *small;
+  /* XXX. State of the on-demand loading of the layers of vals for the tables
+   * opened with memo_open_z, NULL otherwise. Leave this undocumented. */
+  void *lazy;
 } memo_t;
 
 /** Allocate a memoisation structure with enough space for storing counting
@@ -43,14 +49,307 @@ void memo_free(memo_t);
 void memo_dump(FILE *, memo_t);
 
 /** Load the content of a dump (as produced by memo_dump) into a memo_t.
- * It is the caller's responsibility to ensure that there is enough space in
- * the table for the content of the dump. */
-void memo_load(memo_t, FILE *);
+ * Return -1 if the dump is malformed or if one of its cells does not fit in
+ * the table (in which case the table may have been partially filled), and 0
+ * otherwise. */
+int memo_load(memo_t, FILE *);
+
+/** Same as memo_dump, using nb_threads threads for converting the integers to
+ * text. The output is identical to that of memo_dump. */
+void memo_dump_parallel(FILE *, const memo_t, int nb_threads);
+
+/** Same as memo_load, using nb_threads threads for converting the text to
+ * integers. The file is read from its current position to its end (it is
+ * mapped in memory when possible). The errors are reported as by
+ * memo_load. */
+int memo_load_parallel(memo_t, FILE *, int nb_threads);
+
+/** Statistics reported by the compressed dump functions. */
+typedef struct {
+  /** Size in bytes of the same content in the text format of memo_dump (this
+   * is an upper bound, off by at most one byte per non-empty cell) */
+  unsigned long text_size;
+  /** Size in bytes of the compressed dump */
+  unsigned long size;
+  /** CPU time spent encoding or decoding, in seconds */
+  double seconds;
+} memo_z_stats;
+
+/** Maximum length of the model names stored in compressed dumps. */
+#define MEMO_Z_MODEL_LEN 8
+
+/** Dump the content of a memo_t into a file in a compact binary format.
+ * Each row (n, k) of the table is delta-encoded along m and the result is
+ * compressed with a built-in LZ compressor. The dump starts with a versioned
+ * header recording the name of the model the table was computed for (e.g.
+ * "doag"), the dimensions and the bound of the table, and ends with an index
+ * of its layers (indexed by n) with their checksums. See src/common/memo_z.c
+ * for a description of the format.
+ * If stats is not NULL, it is filled with the compression ratio and timing.
+ * Return 0 on success and -1 on I/O error. */
+int memo_dump_z(FILE *, const memo_t, const char *model, memo_z_stats *stats);
+
+/** Read and check the header of a compressed dump, that is the name of the
+ * model (in a buffer of at least MEMO_Z_MODEL_LEN + 1 bytes, unless NULL) and
+ * the N, M and bound fields of the memo_t it was produced from. Return -1 if
+ * the file is not a valid compressed dump. */
+int memo_z_header(FILE *, char *model, int *N, int *M, int *bound);
+
+/** Load all the content of a compressed dump (as produced by memo_dump_z) into
+ * a memo_t. The file must be seekable.
+ * Return -1 if the dump is malformed (including checksum mismatches), if it
+ * was computed for a different bound, or if it does not fit in the table. In
+ * this case the table may have been partially filled. Checking that the dump
+ * was computed for the right model is the caller's responsibility (see
+ * memo_z_header).
+ * If stats is not NULL, it is filled with the compression ratio and timing. */
+int memo_load_z(memo_t, FILE *, memo_z_stats *stats);
+
+/** Same as memo_load_z, but only load the layers of the dump corresponding to
+ * graphs with n_lo to n_hi vertices, seeking directly to them. Since the
+ * counts for n vertices only depend on the layers below n, loading the layers
+ * 2 to n is enough for sampling graphs with n vertices.
+ * The range is clamped to the layers present in the dump. */
+int memo_load_range(memo_t, FILE *, int n_lo, int n_hi);
+
+/** Open a compressed dump (as produced by memo_dump_z) as a memo_t whose
+ * layers are loaded from the file the first time they are accessed, so that
+ * only the layers actually used by the counting and sampling functions are
+ * read. The N and bound fields of the table are those of the dump. Its M
+ * field is that of the dump, or M if it is non-negative and smaller: the
+ * cells with more edges are then not loaded.
+ *
+ * If max_bytes is positive, the least recently used layers are dropped when
+ * the memory of the loaded layers exceeds max_bytes. A layer that cannot be
+ * read back (e.g. because of a checksum mismatch) is left empty and
+ * recomputed by the counting functions, which keep a pointer to the cell
+ * being computed while accessing the layers below it: such layers, when
+ * above the one being accessed, are only released at the next access to a
+ * higher layer, or by memo_lazy_release. The cap is thus approximate.
+ *
+ * The file must be seekable and remain open until the table is freed with
+ * memo_free. Such a table must not be shared between threads.
+ * Return -1 if the file is not a valid compressed dump and 0 otherwise. */
+int memo_open_z(memo_t *, FILE *, int M, size_t max_bytes);
+
+/** Release the memory of the layers dropped from a table opened with
+ * memo_open_z while they could still be in use. Call it when no pointer to a
+ * cell of the table is held, e.g. between two samples. */
+void memo_lazy_release(memo_t);
+
+/* XXX. Load the n-th layer of a table opened with memo_open_z and return it.
+ * Used by memo_get_ptr, leave this undocumented. */
+mpz_t **memo_get_layer(memo_t, int n);
 
 /** Get a pointer to the coefficient of indices (n, m, k) stored in memo.
  * It is the caller's responsibility to ensure that (n, m, k) is not out of
  * bounds. */
-#define memo_get_ptr(memo, n, m, k) (&((memo).vals[(n)-2][(k)-1][m]))
+#define memo_get_ptr(memo, n, m, k)                                            \
+  (&(((memo).vals[(n)-2] != NULL ? (memo).vals[(n)-2]                          \
+                                 : memo_get_layer((memo), (n)))[(k)-1][m]))
+
+/** Compact memoisation structure storing counting information summed over all
+ * the possible numbers of edges, that is indexed by the number of vertices and
+ * sources only.
+ * It occupies O(N^2) integers instead of the O(N^2 * M) integers of a memo_t
+ * and is meant to be used by the samplers that leave the number of edges
+ * free. The integers are exact counts of Theta(N log N) bits, so that its
+ * size still grows like N^3 log N bits. */
+typedef struct {
+  /** The maximum number of vertices of the graphs that this structure can count
+   */
+  int N;
+  /** The maximum out-degree of the graphs that this structure can count */
+  int bound;
+  /* XXX. The integer 0. Leave this undocumented. */
+  mpz_t *zero;
+  /* XXX. The integer 1. Leave this undocumented. */
+  mpz_t *one;
+  /** The array in which counting information is stored. Never manipulate this
+   * directly. */
+  mpz_t **vals;
+} memo_nk_t;
+
+/** Allocate a compact memoisation structure with enough space for storing
+ * counting information for DAGs of max degree bounded by bound, up to N
+ * vertices, and any number of edges.
+ * If a negative bound is passed, allocate enough space for graphs of
+ * unbounded out-degree.
+ *
+ * A structure allocated with this function must be freed using the
+ * memo_nk_free function. */
+memo_nk_t memo_nk_alloc(int N, int bound);
+
+/** Free the memory space occupied by a memo_nk_t allocated by memo_nk_alloc. */
+void memo_nk_free(memo_nk_t);
+
+/** Get a pointer to the coefficient of indices (n, k) stored in memo.
+ * It is the caller's responsibility to ensure that (n, k) is not out of
+ * bounds. */
+#define memo_nk_get_ptr(memo, n, k) (&((memo).vals[(n)-2][(k)-1]))
+
+/** The type of the counting functions of the different models, see e.g.
+ * \ref doag_count. */
+typedef mpz_t *(*randdag_counter_t)(memo_t, int n, int m, int k, int bound);
+
+/** Compute all the counts of the n-th layer of memo (graphs with n vertices)
+ * using `count`, assuming that the layers below n are already filled.
+ * Filling the layers 2 to memo.N one after the other thus fills the whole
+ * table with no deep recursion, and the table is complete up to the last
+ * filled layer at any time (which allows to checkpoint it with memo_dump_z,
+ * see the command line interface). */
+void memo_fill_layer(memo_t, randdag_counter_t count, int n);
+
+/** Same as \ref memo_fill_layer, and set `total` to the number of graphs with
+ * n >= 2 vertices and at most M edges (any number if M is negative), i.e. the
+ * sum of the counts of the layer. The sum is accumulated as the cells are
+ * computed, which saves a second pass over the layer. */
+void memo_fill_layer_total(memo_t, randdag_counter_t count, int n, int M,
+                           mpz_t total);
+
+/** Get a table filled with `count` for graphs of the given model with up to N
+ * vertices and M edges (any number if M is negative) and out-degree bounded by
+ * bound, from the persistent cache directory `dir`.
+ * If dir is NULL, the cache is `$XDG_CACHE_HOME/randdag`, or
+ * `$HOME/.cache/randdag` if XDG_CACHE_HOME is not set. The directory is
+ * created if needed.
+ * The smallest dump of the cache containing all the counts needed is loaded,
+ * only up to N vertices. Otherwise, the dump with the most useful layers is
+ * loaded (if any), the table is completed and written to the cache, replacing
+ * that dump if it contains nothing more. Several processes can use the same
+ * cache concurrently.
+ * The table, stored in `memo`, may have room for more edges than requested,
+ * and must be freed with memo_free.
+ * Return 1 if the table was found in the cache, 0 if it was computed and
+ * stored in the cache, and -1 if it was computed but the cache could not be
+ * used. */
+int memo_cache_get(memo_t *memo, const char *dir, const char *model,
+                   randdag_counter_t count, int N, int M, int bound);
+
+/** Strategies for storing a counting table, see \ref memo_plan. */
+#define MEMO_NONE -1
+#define MEMO_DENSE 0
+#define MEMO_ROLLING 1
+#define MEMO_OUT_OF_CORE 2
+
+/** A memory plan for a counting table, see \ref memo_plan. */
+typedef struct {
+  /** The chosen strategy, one of the MEMO_* constants */
+  int strategy;
+  /** Estimated number of cells of the table */
+  double cells;
+  /** Estimated peak memory, in bytes, of the table with each strategy */
+  double dense, rolling, out_of_core;
+} memo_plan_t;
+
+/** Estimate the memory needed by a table for graphs of the given model
+ * ("doag" or "ldag") with up to N vertices and M edges (any number if M is
+ * negative) and out-degree bounded by bound, and choose how to store it
+ * within max_bytes bytes (no limit if 0). The strategies are tried in the
+ * following order:
+ * - MEMO_DENSE: all the layers in memory, as allocated by memo_alloc;
+ * - MEMO_ROLLING: only two consecutive layers in memory at a time. Since the
+ *   counts for n vertices only depend on the layer n - 1, this is enough for
+ *   computing the counts of each layer in turn, but not for sampling. Only
+ *   considered if all_layers is zero;
+ * - MEMO_OUT_OF_CORE: the layers are loaded on demand from a compressed dump
+ *   (memo_open_z), keeping at least the largest one in memory. Only
+ *   considered if on_disk is non-zero;
+ * - MEMO_NONE: nothing fits.
+ *
+ * The size of a cell is estimated from an upper bound on the bit-length of
+ * its count, derived from the number of labelled DAGs (and, for DOAGs, of the
+ * orderings of the out-edges), plus the overhead of GMP integers. The
+ * estimate does not depend on the actual counts and takes time O(N). */
+memo_plan_t memo_plan(const char *model, int N, int M, int bound,
+                      size_t max_bytes, int all_layers, int on_disk);
+
+/** Engines for sampling graphs, see \ref doag_plan and \ref ldag_plan. */
+#define RD_ENGINE_REJECTION 0
+#define RD_ENGINE_COMPACT 1
+#define RD_ENGINE_SMALL 2
+#define RD_ENGINE_RECURSIVE 3
+
+/** The engine chosen for a sampling request, see \ref doag_plan. */
+typedef struct {
+  /** The chosen engine, one of the RD_ENGINE_* constants */
+  int engine;
+  /** Whether the engine samples from a counting table (memo_t) */
+  int needs_memo;
+  /** Estimated peak memory, in bytes, of the counting information */
+  double bytes;
+  /** Estimated number of operations on big integers of the request */
+  double cost;
+  /** Whether the counting information fits in the memory budget */
+  int fits;
+} sampler_plan_t;
+
+/** Return the name of an engine: "rejection", "compact", "small" or
+ * "recursive". */
+const char *sampler_engine_name(int engine);
+
+/** Cumulative counts of the graphs whose parameters lie in a window, for the
+ * range-conditioned samplers (e.g. \ref doag_unif_window).
+ * Once computed, selecting the parameters of a uniform graph of the window
+ * costs one random draw and a binary search. */
+typedef struct {
+  /** The number of parameter triples of the window with at least one graph */
+  int len;
+  /** The number of vertices of each triple */
+  int *n;
+  /** The number of edges of each triple */
+  int *m;
+  /** The number of sources of each triple */
+  int *k;
+  /** `cumul[i]` is the number of graphs of the triples 0 to i (included) */
+  mpz_t *cumul;
+  /** The bound on the out-degree */
+  int bound;
+} window_t;
+
+/** Compute the cumulative counts of the graphs with:
+ * - between `n_lo` and `n_hi` vertices;
+ * - between `m_lo` and `m_hi` edges;
+ * - between `k_lo` and `k_hi` sources;
+ * - out-degree bounded by `bound` (negative means unbounded).
+ * A negative upper bound on m or k means that this parameter is left free.
+ * Counting is done by `count` using `memo`, which must have enough space for
+ * all the parameters of the window.
+ *
+ * A structure allocated with this function must be freed using the
+ * window_free function. */
+window_t window_alloc(memo_t memo, randdag_counter_t count, int n_lo, int n_hi,
+                      int m_lo, int m_hi, int k_lo, int k_hi, int bound);
+
+/** Free the memory space occupied by a window_t allocated by window_alloc. */
+void window_free(window_t);
+
+/** Select a parameter triple of the window, with probability proportional to
+ * its number of graphs. Return 0 on success and a non-zero value if the window
+ * contains no graph. */
+int window_select(gmp_randstate_t, window_t, int *n, int *m, int *k);
+
+/** Philox4x32-10 counter-based pseudo-random function.
+ * Encrypt the 128-bit counter `ctr` with the 64-bit key `key` and store the
+ * result in `out`. Each array element holds a 32-bit word (upper bits are
+ * ignored).
+ * See: Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC'11. */
+void randdag_philox(const unsigned long key[2], const unsigned long ctr[4],
+                    unsigned long out[4]);
+
+/** Seed a GMP random state with the `index`-th stream of the master seed
+ * `seed`.
+ * The seed of the state is obtained by applying \ref randdag_philox to the
+ * counter `index` with key `seed`, so that the streams of a given master seed
+ * are independent in practice and that each of them can be set up in constant
+ * time, without generating the previous ones.
+ * In particular, drawing the i-th sample of a run from the i-th stream makes
+ * the result independent of the order in which samples are generated, and of
+ * how they are split among threads or machines.
+ * The state must have been initialised beforehand, e.g. by
+ * gmp_randinit_default. */
+void randdag_seed_stream(gmp_randstate_t, unsigned long seed,
+                         unsigned long index);
 
 /** The type of graph vertices */
 typedef struct _randdag_vertex {
@@ -85,4 +384,186 @@ void randdag_free(randdag_t);
  * RD_DOT_LABELLED indicate that the vertices' ids shall be used as labels. */
 void randdag_to_dot(FILE *, const randdag_t, unsigned int flags);
 
+/** Output formats for \ref randdag_write. */
+#define RD_FMT_DOT 0
+#define RD_FMT_EDGES 1
+#define RD_FMT_BIN_EDGES 2
+#define RD_FMT_CSR 3
+
+/** Write a graph to a file in one of the following formats:
+ * - RD_FMT_DOT: graphviz format, as produced by \ref randdag_to_dot;
+ * - RD_FMT_EDGES: plain text edge list, one "u v" line per edge, where u and v
+ *   are vertex ids;
+ * - RD_FMT_BIN_EDGES: binary edge list;
+ * - RD_FMT_CSR: binary compressed sparse row representation.
+ *
+ * In text formats, the edges are listed in the order of the vertices in the
+ * graph and, for each vertex, in the order of its out-edges.
+ *
+ * Both binary formats start with a 24-byte header: a 4-byte magic string
+ * ("RDEL" for edge lists, "RDCS" for CSR), a 4-byte format version (currently
+ * 1), the number of vertices N and the number of edges M over 8 bytes each.
+ * In binary formats, all integers are little-endian and the vertices are
+ * numbered from 0 to N-1 by subtracting the smallest id of the graph from the
+ * vertex ids (the ids of the graphs produced by randdag are consecutive).
+ * The header is followed by:
+ * - RD_FMT_BIN_EDGES: M pairs (source, target) of 4-byte integers, in the same
+ *   order as in text formats;
+ * - RD_FMT_CSR: N+1 offsets over 8 bytes, followed by M targets over 4 bytes.
+ *   The targets of the out-edges of vertex i, in order, are found at indices
+ *   offsets[i] to offsets[i+1]-1.
+ *
+ * Graphs written one after the other to the same file can be read back
+ * sequentially. The `flags` argument is only used for the graphviz format.
+ * The output is buffered internally and written in large chunks.
+ * Return 0 on success and -1 if an I/O error occurred. */
+int randdag_write(FILE *, const randdag_t, int format, unsigned int flags);
+
+/** Output of many graphs to a set of rotating shard files, see
+ * randdag_shards_open. */
+typedef struct randdag_shards randdag_shards_t;
+
+/** Prepare the output of many graphs, in one of the formats of randdag_write,
+ * to the shard files `<prefix>.0`, `<prefix>.1`, etc.
+ * A new shard is started when the current one would exceed max_bytes bytes or
+ * already contains max_graphs graphs (0 meaning no limit; a graph larger than
+ * max_bytes gets a shard on its own). The location of each graph is recorded
+ * in the text file `<prefix>.idx`, one line "shard offset size" per graph
+ * (offset and size being in bytes), in the order in which they are written.
+ *
+ * The files are written by a background thread while the next graphs are
+ * being formatted, using two buffers of a few MiB in turn.
+ * Return NULL if the index cannot be created. */
+randdag_shards_t *randdag_shards_open(const char *prefix, int format,
+                                      unsigned int flags,
+                                      unsigned long max_bytes,
+                                      unsigned long max_graphs);
+
+/** Append a graph to the shards. Return -1 if the format is invalid. Write
+ * errors are reported by randdag_shards_close. */
+int randdag_shards_write(randdag_shards_t *, const randdag_t);
+
+/** Wait for the pending writes, close the files and free the shards. Return
+ * 0 on success and -1 if an I/O error occurred. */
+int randdag_shards_close(randdag_shards_t *);
+
+/** Read-only view of a graph stored in one of the binary formats of
+ * randdag_write (RD_FMT_CSR or RD_FMT_BIN_EDGES), pointing directly into a
+ * file mapped in memory by a randdag_reader_t. Its fields are read with the
+ * randdag_csr_* macros below, which decode the little-endian integers of the
+ * file on the fly. The view is valid until its reader is closed. */
+typedef struct {
+  /** RD_FMT_CSR or RD_FMT_BIN_EDGES */
+  int format;
+  /** The number of vertices (numbered 0 to N-1) and of edges */
+  unsigned long N, M;
+  /* XXX. Pointers into the file, see the macros. Leave this undocumented. */
+  const unsigned char *offsets, *sources, *targets;
+  int stride;
+} randdag_csr_t;
+
+/* XXX. Little-endian integers stored at address p. */
+#define RD_LE32(p)                                                             \
+  ((unsigned long)(p)[0] | (unsigned long)(p)[1] << 8 |                        \
+   (unsigned long)(p)[2] << 16 | (unsigned long)(p)[3] << 24)
+#define RD_LE64(p) (RD_LE32(p) | RD_LE32((p) + 4) << 16 << 16)
+
+/** In CSR format only: the out-edges of vertex i are the edges
+ * randdag_csr_offset(g, i) to randdag_csr_offset(g, i+1) - 1. */
+#define randdag_csr_offset(g, i) RD_LE64((g).offsets + 8 * (i))
+
+/** The target of the j-th edge. */
+#define randdag_csr_target(g, j) RD_LE32((g).targets + (g).stride * (j))
+
+/** In edge list format only: the source of the j-th edge. */
+#define randdag_csr_source(g, j) RD_LE32((g).sources + 8 * (j))
+
+/** Random access reader for graphs written in binary format, either to a
+ * single file or to shards (see randdag_shards_open). */
+typedef struct randdag_reader randdag_reader_t;
+
+/** Open a file containing graphs in binary format written one after the
+ * other. The file is mapped in memory and scanned once to locate the graphs.
+ * Return NULL if the file cannot be mapped or is not a sequence of graphs in
+ * binary format. This function relies on POSIX file mapping. */
+randdag_reader_t *randdag_reader_open(const char *filename);
+
+/** Open a set of shards written by randdag_shards_open in a binary format,
+ * using its index `<prefix>.idx`. The shards are mapped in memory the first
+ * time one of their graphs is accessed. Return NULL if the index cannot be
+ * read. */
+randdag_reader_t *randdag_corpus_open(const char *prefix);
+
+/** The number of graphs available through a reader. */
+unsigned long randdag_reader_len(const randdag_reader_t *);
+
+/** Make g a view of the i-th graph of a reader, without copying it. Return
+ * -1 if i is out of range or if the graph is not valid. */
+int randdag_reader_get(randdag_reader_t *, unsigned long i, randdag_csr_t *g);
+
+/** Unmap the files and free the reader. */
+void randdag_reader_close(randdag_reader_t *);
+
+/** Statistics of graphs for \ref randdag_stats_alloc. The first six are
+ * computed once per graph: number of edges, of sources, of sinks, depth (the
+ * number of edges of the longest path) and largest out- and in-degree. The
+ * last two are computed once per vertex: out- and in-degree. */
+#define RD_STAT_EDGES 1
+#define RD_STAT_SOURCES 2
+#define RD_STAT_SINKS 4
+#define RD_STAT_DEPTH 8
+#define RD_STAT_MAX_OUT 16
+#define RD_STAT_MAX_IN 32
+#define RD_STAT_OUT_DEGREE 64
+#define RD_STAT_IN_DEGREE 128
+#define RD_STAT_ALL 255
+
+/** Statistics aggregated over many graphs, see randdag_stats_alloc. */
+typedef struct randdag_stats randdag_stats_t;
+
+/** Parse a comma-separated list of statistic names (edges, sources, sinks,
+ * depth, max-out-degree, max-in-degree, out-degree, in-degree, or all) into a
+ * combination of the RD_STAT_* flags. Return 0 if the list is invalid. */
+unsigned int randdag_stats_flags(const char *list);
+
+/** Prepare the aggregation of the statistics given by `which`, a combination
+ * of the RD_STAT_* flags, over graphs added one at a time.
+ * Only the exact sum of the values of each statistic, the sum of their
+ * squares and their histogram are stored, so that the graphs themselves need
+ * not be kept and that aggregates computed separately can be merged exactly.
+ * The histograms are sparse above small values: their size depends on the
+ * number of distinct values seen, not on the largest one. */
+randdag_stats_t *randdag_stats_alloc(unsigned int which);
+
+/** Add the statistics of a graph. */
+void randdag_stats_add(randdag_stats_t *, const randdag_t);
+
+/** Add the content of src to dst, which must aggregate the same statistics.
+ */
+void randdag_stats_merge(randdag_stats_t *dst, const randdag_stats_t *src);
+
+/** Sample `count` graphs with `threads` threads and aggregate their
+ * statistics into stats. The i-th graph is `sample(state, i, arg)`, where state
+ * is a GMP random state owned by the calling thread, so that the result does
+ * not depend on the number of threads if the i-th graph only depends on i
+ * (for instance when it is drawn from the i-th stream of a seed, see
+ * \ref randdag_seed_stream). Each thread aggregates its graphs on its own and
+ * the aggregates are merged at the end.
+ * The `sample` function is called concurrently and must be thread-safe. In
+ * particular, the samplers of this library only read their memo_t if all the
+ * counts they need are already computed. This function relies on POSIX
+ * threads. */
+void randdag_stats_sample(randdag_stats_t *stats,
+                          randdag_t (*sample)(gmp_randstate_t, unsigned long i,
+                                              void *arg),
+                          void *arg, unsigned long count, int threads);
+
+/** Print, for each statistic, its number of values, mean, standard deviation,
+ * minimum, quartiles, 5th and 95th percentiles, and maximum. If histograms is
+ * non-zero, also print the number of occurrences of each value. */
+void randdag_stats_print(FILE *, const randdag_stats_t *, int histograms);
+
+/** Free the statistics. */
+void randdag_stats_free(randdag_stats_t *);
+
 #endif
@@ -30,6 +30,17 @@
  */
 mpz_t *doag_count(memo_t, int n, int m, int k, int bound);
 
+/**
+ * Return a pointer to a GMP integer storing the number of DOAGs with:
+ * - `n` vertices (including exactly `k` sources);
+ * - any number of edges;
+ * - out-degree bounded by `bound` (if a negative bound is passed, the bound of
+ *   the memoisation structure is used).
+ * The `memo` argument is a compact memoisation structure (\ref memo_nk_t) built
+ * for this bound and its `N` field must be larger or equal to `n`.
+ */
+mpz_t *doag_count_nk(memo_nk_t, int n, int k, int bound);
+
 /**
  * Return a uniform DOAG with:
  * - `n` vertices (including exactly `k` sources);
@@ -78,9 +89,92 @@ randdag_t doag_unif_nm(gmp_randstate_t, const memo_t, int n, int m, int bound);
 randdag_t doag_unif_nk(gmp_randstate_t, const memo_t, int n, int k, int bound);
 
 /**
- * Return a uniform DOAG with `n` edges.
+ * Return a uniform DOAG with `n` vertices, among those with a single source
+ * and a single sink.
  * This function uses a different algorithm from the other random sampling
  * functions and requires no counting information. */
 randdag_t doag_unif_n(gmp_randstate_t, int n);
 
+/**
+ * Same as \ref doag_unif_n, but write the graph straight to a file in the
+ * binary CSR format of \ref randdag_write (the vertices being numbered 0 to
+ * n-1) instead of building it in memory.
+ * The edge array is written in place in a memory region mapped onto the file,
+ * so that graphs much larger than the available memory can be generated: the
+ * memory used is linear in `n` and not in the number of edges. Given the same
+ * random state, the graph is the same as that of \ref doag_unif_n.
+ * Return 0 on success and -1 if the file cannot be created or written. This
+ * function relies on POSIX file mapping. */
+int doag_unif_n_csr(gmp_randstate_t, int n, const char *filename);
+
+/**
+ * Return a uniform DOAG with:
+ * - `n` vertices;
+ * - out-degree bounded by `bound`.
+ * The number of edges and sources are left free.
+ * This function only requires a compact memoisation structure
+ * (\ref memo_nk_t) and runs in time linear in `n` once the table is filled.
+ * The table holds O(n^2) exact counts of Theta(n log n) bits each, so that
+ * filling it takes time and memory cubic in `n` (up to logarithmic factors):
+ * this sampler is meant for graphs of up to a few thousand vertices, when
+ * only the out-degree is constrained. It does not scale to much larger
+ * graphs, for which no exact sampler with a bounded out-degree is provided:
+ * - `memo.N` must be at least `n`;
+ * - `memo.bound` must be equal to `bound`, or `bound` must be negative.
+ */
+randdag_t doag_unif_n_bounded(gmp_randstate_t, memo_nk_t, int n, int bound);
+
+/**
+ * Return a uniform DOAG among the graphs whose parameters lie in the
+ * window `w`, which must have been computed by \ref window_alloc using
+ * \ref doag_count and the same `memo`.
+ * The parameters are selected in proportion to their counts using the
+ * cumulative sums cached in `w` so that, once the window is computed, the cost
+ * of this function is that of \ref doag_unif_nmk plus a binary search.
+ */
+randdag_t doag_unif_window(gmp_randstate_t, memo_t, window_t w);
+
+/**
+ * Choose the fastest engine for sampling `count` DOAGs with:
+ * - `n` vertices (including exactly `k` sources, or any number if `k` is
+ *   negative);
+ * - `m` edges (any number if `m` is negative);
+ * - out-degree bounded by `bound` (unbounded if `bound` is negative);
+ * whose counting information fits in `max_bytes` bytes (no limit if 0).
+ * The engines are tried in the following order:
+ * - RD_ENGINE_REJECTION: \ref doag_unif_n, which needs no counting
+ *   information, when only the number of vertices is constrained (`m`, `k`
+ *   and `bound` are negative). In this case only, the graphs have a single
+ *   source and a single sink, whatever `n`;
+ * - RD_ENGINE_SMALL: the recursive method, when all the counts for `n`
+ *   vertices fit in machine integers;
+ * - RD_ENGINE_RECURSIVE or RD_ENGINE_COMPACT: the recursive method, which
+ *   fills a counting table (\ref memo_t) once, is the only one handling a
+ *   fixed number of edges or sources. Otherwise, \ref doag_unif_n_bounded
+ *   rebuilds a compact table (\ref memo_nk_t) for each graph, which is
+ *   cheaper for a few graphs, and is used when the full table does not fit.
+ * The choice relies on the memory estimates of \ref memo_plan and on a rough
+ * count of the operations on big integers, reported in the result together
+ * with whether the chosen engine fits in `max_bytes`.
+ */
+sampler_plan_t doag_plan(int n, int m, int k, int bound, unsigned long count,
+                         size_t max_bytes);
+
+/**
+ * Return a uniform DOAG with `n` vertices, `m` edges and `k` sources (any
+ * number of them if negative) and out-degree bounded by `bound`, using the
+ * engine chosen by \ref doag_plan for these parameters. The rejection engine
+ * ignores `m`, `k` and `bound` and draws a DOAG with a single source and a
+ * single sink (see \ref doag_unif_n). If the engine
+ * samples from a counting table (its `needs_memo` field), `memo` must have
+ * enough space for all the precomputation (see \ref doag_unif_nmk),
+ * otherwise it is ignored.
+ * When both the number of edges and of sources are free, the recursive
+ * engines select them from marginal counts computed at each call: for many
+ * graphs, compute them once with \ref window_alloc and use
+ * \ref doag_unif_window instead.
+ */
+randdag_t doag_unif_engine(gmp_randstate_t, memo_t, int engine, int n,
+                           int m, int k, int bound);
+
 #endif
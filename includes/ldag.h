@@ -27,6 +27,17 @@
  */
 mpz_t *ldag_count(memo_t, int n, int m, int k, int bound);
 
+/**
+ * Return a pointer to a GMP integer storing the number of labelled DAGs with:
+ * - `n` vertices (including exactly `k` sources);
+ * - any number of edges;
+ * - out-degree bounded by `bound` (if a negative bound is passed, the bound of
+ *   the memoisation structure is used).
+ * The `memo` argument is a compact memoisation structure (\ref memo_nk_t) built
+ * for this bound and its `N` field must be larger or equal to `n`.
+ */
+mpz_t *ldag_count_nk(memo_nk_t, int n, int k, int bound);
+
 /**
  * Return a uniform labelled DAG with:
  * - `n` vertices (including exactly `k` sources);
@@ -91,4 +102,65 @@ randdag_t ldag_unif_nk(gmp_randstate_t, memo_t, int n, int k, int bound);
  */
 randdag_t ldag_unif_n(gmp_randstate_t, memo_t, int m, int bound);
 
+/**
+ * Return a uniform labelled DAG with:
+ * - `n` vertices;
+ * - out-degree bounded by `bound`.
+ * The number of edges and sources are left free.
+ * This function only requires a compact memoisation structure
+ * (\ref memo_nk_t), whose O(n^2) exact counts have Theta(n log n) bits each.
+ * Filling it takes time and memory cubic in `n` (up to logarithmic factors),
+ * so that it is meant for graphs of up to a few thousand vertices:
+ * - `memo.N` must be at least `n`;
+ * - `memo.bound` must be equal to `bound`, or `bound` must be negative.
+ */
+randdag_t ldag_unif_n_bounded(gmp_randstate_t, memo_nk_t, int n, int bound);
+
+/**
+ * Return a uniform labelled DAG among the graphs whose parameters lie in the
+ * window `w`, which must have been computed by \ref window_alloc using
+ * \ref ldag_count and the same `memo`.
+ * The parameters are selected in proportion to their counts using the
+ * cumulative sums cached in `w` so that, once the window is computed, the cost
+ * of this function is that of \ref ldag_unif_nmk plus a binary search.
+ */
+randdag_t ldag_unif_window(gmp_randstate_t, memo_t, window_t w);
+
+/**
+ * Choose the fastest engine for sampling `count` labelled DAGs with:
+ * - `n` vertices (including exactly `k` sources, or any number if `k` is
+ *   negative);
+ * - `m` edges (any number if `m` is negative);
+ * - out-degree bounded by `bound` (unbounded if `bound` is negative);
+ * whose counting information fits in `max_bytes` bytes (no limit if 0).
+ * The engines are tried in the following order:
+ * - RD_ENGINE_SMALL: the recursive method, when all the counts for `n`
+ *   vertices fit in machine integers;
+ * - RD_ENGINE_RECURSIVE or RD_ENGINE_COMPACT: the recursive method, which
+ *   fills a counting table (\ref memo_t) once, is the only one handling a
+ *   fixed number of edges or sources. Otherwise, \ref ldag_unif_n_bounded
+ *   rebuilds a compact table (\ref memo_nk_t) for each graph, which is
+ *   cheaper for a few graphs, and is used when the full table does not fit.
+ * The choice relies on the memory estimates of \ref memo_plan and on a rough
+ * count of the operations on big integers, reported in the result together
+ * with whether the chosen engine fits in `max_bytes`.
+ */
+sampler_plan_t ldag_plan(int n, int m, int k, int bound, unsigned long count,
+                         size_t max_bytes);
+
+/**
+ * Return a uniform labelled DAG with `n` vertices, `m` edges and `k` sources
+ * (any number of them if negative) and out-degree bounded by `bound`, using
+ * the engine chosen by \ref ldag_plan for these parameters. If the engine
+ * samples from a counting table (its `needs_memo` field), `memo` must have
+ * enough space for all the precomputation (see \ref ldag_unif_nmk),
+ * otherwise it is ignored.
+ * When both the number of edges and of sources are free, the recursive
+ * engines select them from marginal counts computed at each call: for many
+ * graphs, compute them once with \ref window_alloc and use
+ * \ref ldag_unif_window instead.
+ */
+randdag_t ldag_unif_engine(gmp_randstate_t, memo_t, int engine, int n,
+                           int m, int k, int bound);
+
 #endif
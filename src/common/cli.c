@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 /* Randdag: C library for the uniform random generation of DAGs
 
    Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
@@ -22,15 +23,23 @@
    > When using any of these functions, it is a good idea to include stdio.h
    > before gmp.h, since that will allow gmp.h to define prototypes for these
    > functions. */
+#include <errno.h>      /* errno, EINVAL */
+#include <fcntl.h>      /* open */
 #include <gmp.h>        /* mpz_* */
 #include <limits.h>     /* INT_MAX */
 #include <malloc.h>     /* malloc, realloc */
 #include <stdlib.h>     /* strtol, exit */
-#include <string.h>     /* strcmp */
+#include <string.h>     /* strcmp, strrchr */
 #include <sys/random.h> /* getrandom (linux only) */
+#include <sys/stat.h>   /* stat */
+#include <time.h>       /* time, difftime */
+#include <unistd.h>     /* fsync, close */
 
 #include "../../lib/argtable3/argtable3.h"
 #include "cli.h"
+#include "memo.h"
+#include "progress.h"
+#include "small.h"
 
 #define max(x, y) (((x) < (y)) ? (y) : (x))
 #define min(x, y) (((x) < (y)) ? (x) : (y))
@@ -70,51 +79,262 @@ static char *mygetline(size_t *n, FILE *stream) {
   }
 }
 
+/* Command line options */
+
+typedef struct cli_options {
+  int N, M, K, bound, count, format, compress, threads, cache_mb, max_mb;
+  int checkpoint_every, nb_samples, shard_mb, shard_graphs, has_seed;
+  unsigned long seed;
+  /* Whether --count only counts the graphs with exactly N vertices. */
+  int exact;
+  const char *checkpoint_file;
+  const char *serve_path;
+  /* Statistics of --stats (a combination of the RD_STAT_* flags, 0 if
+   * disabled) and whether to print their histograms. */
+  unsigned int stats;
+  int histograms;
+  /* Whether to run the jobs of the standard input. */
+  int pipe;
+  /* Whether to report progress, and to print the timings of the phases of
+   * the run (1 as text, 2 as JSON). */
+  int progress, timings;
+  /* Parameters of --query, '*' being stored as -1. */
+  int query, query_n, query_m, query_k;
+  /* Whether to use the persistent cache, and its directory (NULL for the
+   * default one). */
+  int cache;
+  const char *cache_dir;
+  const char *sample_file;
+  const char *dump_file;
+  const char *load_file;
+} cli_options;
+
 /* Generic commands */
 
-static int generic_sampler(const char *filename, memo_t memo,
-                           __sampler_t sampler, long flags, int n, int m,
-                           int bound) {
-  FILE *ofile;
+randdag_t cli_sample(__sampler_t sampler, int engine, gmp_randstate_t state,
+                     memo_t memo, const window_t *w, int n, int m, int k,
+                     int bound, unsigned long seed, unsigned long i) {
+  randdag_t g;
+
+  randdag_seed_stream(state, seed, i);
+  if (w != NULL)
+    window_select(state, *w, &n, &m, &k);
+  g = sampler(state, memo, engine, n, m, k, bound);
+  if (memo.lazy != NULL)
+    memo_lazy_release(memo);
+  return g;
+}
+
+/* The seed of --seed, or a random one. */
+static unsigned long cli_seed(const cli_options *opts) {
+  unsigned long seed;
+  if (opts->has_seed)
+    return opts->seed;
+  getrandom(&seed, sizeof(unsigned long int), 0); /* XXX. Linux only */
+  fprintf(stderr, "Using random seed 0x%lx\n", seed);
+  return seed;
+}
+
+/* Whether the graph of a run can be written by the streaming CSR writer of
+ * the model: a single graph of the rejection engine, in CSR format, to a
+ * regular file (or a new one) since the writer maps it in memory. */
+static int _streams_csr(const cli_options *opts, __csr_writer_t csr,
+                        const sampler_plan_t *plan, int sharded) {
+  struct stat st;
+
+  if (csr == NULL || plan->engine != RD_ENGINE_REJECTION || sharded ||
+      opts->format != RD_FMT_CSR)
+    return 0;
+  if (strcmp(opts->sample_file, "-") == 0)
+    return 0;
+  return stat(opts->sample_file, &st) != 0 || S_ISREG(st.st_mode);
+}
+
+static int generic_sampler(const cli_options *opts, memo_t memo,
+                           __counter_t counter, __sampler_t sampler,
+                           __csr_writer_t csr, const sampler_plan_t *plan,
+                           long flags, timings_t *timings) {
+  FILE *ofile = NULL;
+  randdag_shards_t *shards = NULL;
   gmp_randstate_t state;
-  unsigned long int seed;
+  unsigned long int seed, i;
+  double start, last = 0;
+  window_t w;
   randdag_t g;
+  int error = 0;
+  const char *filename = opts->sample_file;
+  /* Several samples, or explicit shard limits, go to shard files. */
+  const int sharded =
+      opts->nb_samples > 1 || opts->shard_mb > 0 || opts->shard_graphs > 0;
+  /* The samplers using the table select the number of edges and sources from
+   * marginal counts: compute them once for all the samples. */
+  const int windowed = plan->needs_memo;
+
+  if (windowed) {
+    w = window_alloc(memo, counter, opts->N, opts->N, opts->M, opts->M,
+                     opts->K, opts->K, opts->bound);
+    if (w.len == 0) {
+      fprintf(stderr, "Invalid parameters, there is no graph to sample\n");
+      window_free(w);
+      return EXIT_FAILURE;
+    }
+  }
+  timings_end(timings, PHASE_SAMPLE);
 
-  /* Open the output file. */
-  ofile = (strcmp("-", filename) == 0) ? stdout : fopen(filename, "w");
-  if (ofile == NULL) {
+  /* Write the graph to its file as it is drawn, without building it in
+   * memory. It is the graph that cli_sample would return. */
+  if (_streams_csr(opts, csr, plan, sharded)) {
+    gmp_randinit_mt(state);
+    seed = cli_seed(opts);
+    randdag_seed_stream(state, seed, 0);
+    start = progress_now();
+    error = csr(state, opts->N, filename) != 0;
+    if (error)
+      fprintf(stderr, "Error while writing to file: %s\n", filename);
+    gmp_randclear(state);
+    timings_end(timings, PHASE_WRITE);
+    if (opts->progress)
+      progress_samples(1, 1, start, &last);
+    return error ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
+  /* Open the output file(s). */
+  if (sharded) {
+    shards = randdag_shards_open(filename, opts->format, flags,
+                                 (unsigned long)opts->shard_mb << 20,
+                                 opts->shard_graphs);
+  } else {
+    ofile = (strcmp("-", filename) == 0) ? stdout : fopen(filename, "w");
+  }
+  if (ofile == NULL && shards == NULL) {
     fprintf(stderr, "Cannot open file: %s\n", filename);
+    if (windowed)
+      window_free(w);
     return EXIT_FAILURE;
   }
 
-  /* Prepare the RNG */
+  /* Prepare the RNG: the i-th sample is drawn from the i-th stream of the
+   * seed, so that it can be reproduced alone. */
   gmp_randinit_mt(state);
-  getrandom(&seed, sizeof(unsigned long int), 0); /* XXX. Linux only */
-  fprintf(stderr, "Using random seed 0x%lx\n", seed);
-  gmp_randseed_ui(state, seed);
+  seed = cli_seed(opts);
 
   /* Call the sampler. */
-  g = sampler(state, memo, n, m, bound);
-  randdag_to_dot(ofile, g, flags);
+  timings_end(timings, PHASE_WRITE);
+  start = progress_now();
+  for (i = 0; i < (unsigned long)opts->nb_samples; i++) {
+    g = cli_sample(sampler, plan->engine, state, memo, windowed ? &w : NULL,
+                   opts->N, opts->M, opts->K, opts->bound, seed, i);
+    timings_end(timings, PHASE_SAMPLE);
+    if (sharded)
+      error |= randdag_shards_write(shards, g);
+    else
+      error |= randdag_write(ofile, g, opts->format, flags);
+    randdag_free(g);
+    timings_end(timings, PHASE_WRITE);
+    if (opts->progress)
+      progress_samples(i + 1, opts->nb_samples, start, &last);
+  }
 
   /* Do some cleanups. */
-  if (ofile != stdout)
-    fclose(ofile);
-  randdag_free(g);
+  if (sharded)
+    error |= randdag_shards_close(shards);
+  else if (ofile != stdout)
+    error |= fclose(ofile) != 0;
+  else
+    error |= fflush(stdout) != 0;
+  if (error)
+    fprintf(stderr, "Error while writing to file: %s\n", filename);
+  if (windowed)
+    window_free(w);
   gmp_randclear(state);
+  timings_end(timings, PHASE_WRITE);
+
+  return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* The closure passed to randdag_stats_sample. */
+typedef struct {
+  const cli_options *opts;
+  memo_t memo;
+  __sampler_t sampler;
+  int engine;
+  const window_t *w;
+  unsigned long seed;
+} _stats_closure;
 
+static randdag_t _stats_sample(gmp_randstate_t state, unsigned long i,
+                               void *arg) {
+  const _stats_closure *c = arg;
+  return cli_sample(c->sampler, c->engine, state, c->memo, c->w, c->opts->N,
+                    c->opts->M, c->opts->K, c->opts->bound, c->seed, i);
+}
+
+/* Print statistics of the graphs that --sample would draw, without writing
+ * them. */
+static int generic_stats(const cli_options *opts, memo_t memo,
+                         __counter_t counter, __sampler_t sampler,
+                         const sampler_plan_t *plan) {
+  window_t w;
+  randdag_stats_t *stats;
+  _stats_closure c;
+  int threads = opts->threads;
+  const int windowed = plan->needs_memo;
+
+  if (windowed) {
+    w = window_alloc(memo, counter, opts->N, opts->N, opts->M, opts->M,
+                     opts->K, opts->K, opts->bound);
+    if (w.len == 0) {
+      fprintf(stderr, "Invalid parameters, there is no graph to sample\n");
+      window_free(w);
+      return EXIT_FAILURE;
+    }
+    /* The samplers only read the table once it is complete, which is what
+     * allows several threads to share it. Tables loaded on demand are not
+     * thread-safe. */
+    if (memo.lazy != NULL) {
+      threads = 1;
+    } else if (threads > 1) {
+      int n;
+      for (n = 2; n <= memo.N; n++)
+        memo_fill_layer(memo, counter, n);
+    }
+  }
+
+  c.opts = opts;
+  c.memo = memo;
+  c.sampler = sampler;
+  c.engine = plan->engine;
+  c.w = windowed ? &w : NULL;
+  c.seed = cli_seed(opts);
+
+  stats = randdag_stats_alloc(opts->stats);
+  randdag_stats_sample(stats, _stats_sample, &c, opts->nb_samples, threads);
+  randdag_stats_print(stdout, stats, opts->histograms);
+  randdag_stats_free(stats);
+
+  if (windowed)
+    window_free(w);
   return EXIT_SUCCESS;
 }
 
+/* Print the number of graphs of each size up to N or, if exact is non-zero,
+ * of size N only: the layers below N are then filled without summing them.
+ * The total of each layer is accumulated while it is filled (see
+ * memo_fill_layer_total). If rolling is non-zero, the layers of memo must be
+ * unallocated (see memo_alloc_empty): they are then filled in order, keeping
+ * only two of them in memory. */
 static void generic_counter(__counter_t count, memo_t memo, int N, int M,
-                            int bound) {
-  int n, m, k, max_m;
+                            int bound, int rolling, int exact) {
+  int n;
   mpz_t sum;
 
   mpz_init(sum);
 
   /* Head line */
-  printf("Graphs with n vertices");
+  if (exact)
+    printf("Graphs with %d vertices", N);
+  else
+    printf("Graphs with n vertices");
   if (M >= 0)
     printf(", at most %d edges", M);
   if (bound >= 0)
@@ -123,15 +343,24 @@ static void generic_counter(__counter_t count, memo_t memo, int N, int M,
 
   /* Counting. */
   for (n = 0; n <= N; n++) {
-    mpz_set_ui(sum, 0);
-    for (k = (n > 0); k <= n; k++) {
-      const int C = min(n - k, (bound < 0 ? n : bound));
-      max_m = (C * (C - 1)) / 2 + (n - C) * C;
-      max_m = M < 0 ? max_m : min(max_m, M);
-      for (m = n - k; m <= max_m; m++) {
-        mpz_add(sum, sum, *count(memo, n, m, k, bound));
-      }
+    if (rolling && n >= 2)
+      memo.vals[n - 2] = memo_layer_alloc(n, memo.M, memo.bound);
+
+    /* There is one graph with no vertex and one with a single vertex. */
+    if (n < 2)
+      mpz_set_ui(sum, 1);
+    else if (exact && n < N)
+      memo_fill_layer(memo, count, n);
+    else
+      memo_fill_layer_total(memo, count, n, M, sum);
+
+    /* The layer n only depends on the layer n - 1. */
+    if (rolling && n >= 3) {
+      memo_layer_free(memo.vals[n - 3], n - 1, memo.M, memo.bound);
+      memo.vals[n - 3] = NULL;
     }
+    if (exact && n < N)
+      continue;
 
     printf("n=%-6d ", n);
     mpz_out_str(stdout, 10, sum);
@@ -142,24 +371,110 @@ static void generic_counter(__counter_t count, memo_t memo, int N, int M,
   mpz_clear(sum);
 }
 
+/* Number of non-zero cells of the layers of memo that are in memory, and of
+ * its small table. */
+static void nonzero_cells(memo_t memo, unsigned long *cells,
+                          unsigned long *small_cells) {
+  int n, m, k;
+  const small_table *t = memo.small;
+
+  *cells = *small_cells = 0;
+  for (n = 2; n <= memo.N; n++) {
+    if (memo.vals[n - 2] == NULL)
+      continue;
+    for (k = 1; k <= n; k++) {
+      const int C = min(memo.bound, n - k);
+      const int max_m = min((C - 1) * C / 2 + C * (n - C), memo.M);
+      for (m = 0; m <= max_m; m++)
+        *cells += mpz_sgn(memo.vals[n - 2][k - 1][m]) != 0;
+    }
+  }
+  for (n = 2; n <= t->N; n++) {
+    for (k = 1; k <= n; k++) {
+      const int C = min(memo.bound, n - k);
+      const int max_m = min((C - 1) * C / 2 + C * (n - C), memo.M);
+      for (m = 0; m <= max_m; m++)
+        *small_cells += t->vals[n - 2][k - 1][m] != 0;
+    }
+  }
+}
+
+/* Count the graphs with n vertices, m edges and k sources, summing over all
+ * the values of m and/or k if they are negative. Only the cells reachable from
+ * these parameters are computed. */
+static void generic_query(__counter_t count, memo_t memo, int n, int m, int k,
+                          int bound) {
+  int m2, k2;
+  unsigned long cells0, small0, cells, small;
+  mpz_t sum;
+  clock_t start;
+  const int B = bound < 0 ? n : bound;
+
+  mpz_init(sum);
+  nonzero_cells(memo, &cells0, &small0);
+  start = clock();
+
+  for (k2 = (k < 0 ? 0 : k); k2 <= (k < 0 ? n : k); k2++) {
+    const int C = min(n - k2, B);
+    const int max_m = (C * (C - 1)) / 2 + C * (n - C);
+    for (m2 = (m < 0 ? 0 : m); m2 <= (m < 0 ? max_m : m); m2++)
+      mpz_add(sum, sum, *count(memo, n, m2, k2, bound));
+  }
+
+  mpz_out_str(stdout, 10, sum);
+  printf("\n");
+  fflush(stdout);
+
+  nonzero_cells(memo, &cells, &small);
+  fprintf(stderr,
+          "Computed %lu cells (and %lu machine-integer cells) in %.3fs\n",
+          cells - cells0, small - small0,
+          (double)(clock() - start) / CLOCKS_PER_SEC);
+  mpz_clear(sum);
+}
+
+/* Parse the argument of --query. */
+static int parse_query(const char *q, cli_options *opts) {
+  char *end;
+  int i, *fields[3];
+
+  fields[0] = &opts->query_n;
+  fields[1] = &opts->query_m;
+  fields[2] = &opts->query_k;
+  for (i = 0; i < 3; i++) {
+    if (i > 0 && *q++ != ',')
+      return -1;
+    if (i > 0 && *q == '*') {
+      *fields[i] = -1;
+      q++;
+    } else {
+      const long x = strtol(q, &end, 10);
+      if (end == q || x < 0 || x > INT_MAX)
+        return -1;
+      *fields[i] = x;
+      q = end;
+    }
+  }
+  return *q == '\0' ? 0 : -1;
+}
+
 /* Command line parsing */
 
-typedef struct cli_options {
-  int N, M, bound, count;
-  const char *sample_file;
-  const char *dump_file;
-  const char *load_file;
-} cli_options;
 
 /* FIXME: these should be local variables. */
-struct arg_lit *help, *count;
-struct arg_int *arg_N, *arg_M, *arg_B;
-struct arg_file *sample, *dump, *load;
+struct arg_lit *help, *count, *compress, *arg_cache_lit, *arg_histograms;
+struct arg_lit *arg_progress, *arg_pipe, *arg_exact;
+struct arg_int *arg_N, *arg_M, *arg_B, *arg_T, *arg_cache, *arg_every;
+struct arg_int *arg_max_mem;
+struct arg_int *arg_K, *arg_S, *arg_shard_mb, *arg_shard_graphs;
+struct arg_file *sample, *dump, *load, *arg_checkpoint, *arg_serve;
+struct arg_file *arg_cache_dir;
+struct arg_str *format, *arg_seed, *arg_query, *arg_stats, *arg_timings;
 struct arg_end *end;
 
 static int cli_parse(int argc, char *argv[], cli_options *opts) {
   int exitcode, nerrors;
-  void *argtable[9];
+  void *argtable[31];
 
   argtable[0] = help =
       arg_litn("h", "help", 0, 1, "Display this help and exit.");
@@ -179,21 +494,132 @@ static int cli_parse(int argc, char *argv[], cli_options *opts) {
       "sampling. Negative means unbounded. Defaults to -1.");
 
   /* Counting and sampling. */
-  argtable[4] = count = arg_litn(
+  argtable[4] = arg_S =
+      arg_intn("k", "sources", "<K>", 0, 1,
+               "Set the exact number of sources for sampling. Negative means "
+               "any. Defaults to -1.");
+
+  argtable[5] = count = arg_litn(
       /* FIXME: use the name DOAG/LDAG here. */
       "c", "count", 0, 1, "Count graphs with up to N vertices and M edges");
-  argtable[5] = sample = arg_filen("s", "sample", "<file>", 0, 1,
+  argtable[6] = arg_exact =
+      arg_litn(NULL, "exact", 0, 1,
+               "With -c, only count the graphs with exactly N vertices");
+  argtable[7] = arg_query =
+      arg_strn("q", "query", "<n,m,k>", 0, 1,
+               "Count the graphs with n vertices, m edges and k sources, "
+               "where m and/or k can be * to sum over all their values. Only "
+               "the counts needed for the result are computed.");
+  argtable[8] = sample = arg_filen("s", "sample", "<file>", 0, 1,
                                    /* FIXME: use the name DOAG/LDAG here. */
                                    "write a uniform graph with N vertices "
                                    "(and, if specified, M edges) to <file>");
+  argtable[9] = format = arg_strn(
+      "f", "format", "<fmt>", 0, 1,
+      "output format of the samples: dot (default), edges (text edge list), "
+      "bin (binary edge list) or csr (binary CSR)");
+  argtable[10] = arg_K =
+      arg_intn(NULL, "count-samples", "<K>", 0, 1,
+               "number of graphs to sample. Several graphs are written to "
+               "the shard files <file>.0, <file>.1, etc. with an index of "
+               "their offsets in <file>.idx. Defaults to 1.");
+  argtable[11] = arg_seed =
+      arg_strn(NULL, "seed", "<S>", 0, 1,
+               "seed of the random generator: the i-th graph is drawn from "
+               "the i-th stream of <S>, so that the graphs only depend on "
+               "<S>. Defaults to a random seed.");
+  argtable[12] = arg_shard_mb =
+      arg_intn(NULL, "shard-size", "<MiB>", 0, 1,
+               "start a new shard when the current one would exceed <MiB> "
+               "MiB. Defaults to 0 (no limit).");
+  argtable[13] = arg_shard_graphs =
+      arg_intn(NULL, "shard-graphs", "<G>", 0, 1,
+               "start a new shard after <G> graphs. Defaults to 0 (no "
+               "limit).");
+  argtable[14] = arg_stats =
+      arg_strn(NULL, "stats", "<list>", 0, 1,
+               "print statistics of the graphs of --count-samples instead of "
+               "writing them: mean, standard deviation and percentiles of "
+               "the comma-separated <list> among edges, sources, sinks, "
+               "depth, max-out-degree, max-in-degree, out-degree, in-degree "
+               "and all. The graphs are sampled with T threads.");
+  argtable[15] = arg_histograms =
+      arg_litn(NULL, "histograms", 0, 1,
+               "also print the histograms of the statistics");
 
   /* Memoisation table management. */
-  argtable[6] = dump =
+  argtable[16] = dump =
       arg_filen("d", "dump", "<file>", 0, 1, "dump counting info to <file>");
-  argtable[7] = load =
+  argtable[17] = load =
       arg_filen("l", "load", "<file>", 0, 1, "load counting info from <file>");
+  argtable[18] = compress =
+      arg_litn("z", "compress", 0, 1,
+               "dump counting info in compressed binary format (compressed "
+               "dumps are detected automatically when loading)");
+
+  argtable[19] = arg_T =
+      arg_intn("j", "threads", "<T>", 0, 1,
+               "number of threads used for loading and dumping counting info "
+               "in text format, for serving requests, or for sampling with "
+               "--stats. Defaults to 1.");
+
+  argtable[20] = arg_cache =
+      arg_intn(NULL, "cache-mem", "<MiB>", 0, 1,
+               "when sampling from a compressed dump, its layers are loaded "
+               "on demand; drop the least recently used ones above <MiB> MiB "
+               "of memory. Defaults to 0 (no limit).");
+  argtable[21] = arg_max_mem =
+      arg_intn(NULL, "max-mem", "<MiB>", 0, 1,
+               "estimate the memory needed by the table before computing it "
+               "and keep it under <MiB> MiB: keep only two layers at a time "
+               "when only counting, load the layers of a compressed dump on "
+               "demand, or fail at once if the table cannot fit. Defaults to "
+               "0 (no limit).");
+
+  argtable[22] = arg_checkpoint =
+      arg_filen(NULL, "checkpoint", "<file>", 0, 1,
+                "fill the table one layer at a time, periodically saving the "
+                "completed layers to <file>, and resume from <file> if it "
+                "exists");
+  argtable[23] = arg_every =
+      arg_intn(NULL, "checkpoint-every", "<S>", 0, 1,
+               "minimum number of seconds between two checkpoints. Defaults "
+               "to 300.");
+
+  argtable[24] = arg_cache_lit =
+      arg_litn(NULL, "cache", 0, 1,
+               "look the table up in the persistent cache of counting info "
+               "($XDG_CACHE_HOME/randdag by default), computing it and "
+               "storing it there if needed");
+  argtable[25] = arg_cache_dir =
+      arg_filen(NULL, "cache-dir", "<dir>", 0, 1,
+                "use <dir> as the cache directory (implies --cache)");
+
+  argtable[26] = arg_serve =
+      arg_filen(NULL, "serve", "<socket>", 0, 1,
+                "serve sampling requests on the Unix domain socket <socket> "
+                "with T worker threads, keeping the counting info in memory "
+                "between requests (see the README for the protocol)");
+  argtable[27] = arg_pipe =
+      arg_litn(NULL, "pipe", 0, 1,
+               "run the sampling jobs read from the standard input with T "
+               "worker threads, keeping the counting info in memory between "
+               "jobs (see the README for the format of the jobs)");
 
-  argtable[8] = end = arg_end(10);
+  /* Monitoring. */
+  argtable[28] = arg_progress =
+      arg_litn(NULL, "progress", 0, 1,
+               "fill the table one layer at a time before using it, "
+               "reporting the current layer, the number of cells filled per "
+               "second, the estimated remaining time and the resident memory; "
+               "also report the progress of sampling");
+  argtable[29] = arg_timings =
+      arg_strn(NULL, "timings", "<fmt>", 0, 1,
+               "at exit, print the time spent allocating, loading, counting, "
+               "sampling, writing and dumping, the peak resident memory and "
+               "the sampling engine, as text or json");
+
+  argtable[30] = end = arg_end(10);
 
   exitcode = EXIT_SUCCESS;
   nerrors = arg_parse(argc, argv, argtable);
@@ -223,13 +649,125 @@ static int cli_parse(int argc, char *argv[], cli_options *opts) {
   }
 
   opts->M = (arg_M->count > 0) ? arg_M->ival[0] : -1;
+  opts->K = (arg_S->count > 0) ? arg_S->ival[0] : -1;
   opts->bound = (arg_B->count > 0) ? arg_B->ival[0] : -1;
+  opts->threads = (arg_T->count > 0) ? arg_T->ival[0] : 1;
+  if (opts->threads < 1) {
+    fprintf(stderr, "[-j|--threads] expects a positive integer.\n");
+    exitcode = EXIT_FAILURE;
+    goto exit;
+  }
+  opts->nb_samples = (arg_K->count > 0) ? arg_K->ival[0] : 1;
+  opts->shard_mb = (arg_shard_mb->count > 0) ? arg_shard_mb->ival[0] : 0;
+  opts->shard_graphs =
+      (arg_shard_graphs->count > 0) ? arg_shard_graphs->ival[0] : 0;
+  if (opts->nb_samples < 1 || opts->shard_mb < 0 || opts->shard_graphs < 0) {
+    fprintf(stderr, "[--count-samples] expects a positive integer, "
+                    "[--shard-size|--shard-graphs] non-negative integers.\n");
+    exitcode = EXIT_FAILURE;
+    goto exit;
+  }
+  opts->has_seed = (arg_seed->count > 0);
+  if (opts->has_seed) {
+    char *end_ptr;
+    opts->seed = strtoul(arg_seed->sval[0], &end_ptr, 0);
+    if (*arg_seed->sval[0] == '\0' || *end_ptr != '\0') {
+      fprintf(stderr, "[--seed] expects a non-negative integer.\n");
+      exitcode = EXIT_FAILURE;
+      goto exit;
+    }
+  }
+  opts->checkpoint_every = (arg_every->count > 0) ? arg_every->ival[0] : 300;
+  opts->cache_mb = (arg_cache->count > 0) ? arg_cache->ival[0] : 0;
+  opts->max_mb = (arg_max_mem->count > 0) ? arg_max_mem->ival[0] : 0;
+  if (opts->cache_mb < 0 || opts->max_mb < 0) {
+    fprintf(stderr,
+            "[--cache-mem|--max-mem] expect non-negative integers.\n");
+    exitcode = EXIT_FAILURE;
+    goto exit;
+  }
+
+  opts->stats = 0;
+  if (arg_stats->count > 0) {
+    opts->stats = randdag_stats_flags(arg_stats->sval[0]);
+    if (opts->stats == 0) {
+      fprintf(stderr, "[--stats] expects a comma-separated list among edges, "
+                      "sources, sinks, depth, max-out-degree, max-in-degree, "
+                      "out-degree, in-degree and all.\n");
+      exitcode = EXIT_FAILURE;
+      goto exit;
+    }
+  }
+
+  opts->timings = 0;
+  if (arg_timings->count > 0) {
+    if (strcmp(arg_timings->sval[0], "text") == 0)
+      opts->timings = 1;
+    else if (strcmp(arg_timings->sval[0], "json") == 0)
+      opts->timings = 2;
+    else {
+      fprintf(stderr, "[--timings] expects one of text, json.\n");
+      exitcode = EXIT_FAILURE;
+      goto exit;
+    }
+  }
+
+  /* Queries replace the size parameters. */
+  opts->query = (arg_query->count > 0);
+  if (opts->query) {
+    if (parse_query(arg_query->sval[0], opts) != 0) {
+      fprintf(stderr, "[-q|--query] expects n,m,k where n, m and k are "
+                      "non-negative integers, m and k can also be *.\n");
+      exitcode = EXIT_FAILURE;
+      goto exit;
+    }
+    opts->N = opts->query_n;
+    opts->M = opts->query_m;
+  }
+
+  /* Output format. */
+  opts->format = RD_FMT_DOT;
+  if (format->count > 0) {
+    const char *f = format->sval[0];
+    if (strcmp(f, "dot") == 0)
+      opts->format = RD_FMT_DOT;
+    else if (strcmp(f, "edges") == 0)
+      opts->format = RD_FMT_EDGES;
+    else if (strcmp(f, "bin") == 0)
+      opts->format = RD_FMT_BIN_EDGES;
+    else if (strcmp(f, "csr") == 0)
+      opts->format = RD_FMT_CSR;
+    else {
+      fprintf(stderr, "[-f|--format] expects one of dot, edges, bin, csr.\n");
+      exitcode = EXIT_FAILURE;
+      goto exit;
+    }
+  }
 
   /* Store the other flags and filenames. */
   opts->count = (count->count > 0);
+  opts->exact = (arg_exact->count > 0);
+  opts->compress = (compress->count > 0);
   opts->sample_file = (sample->count > 0) ? sample->filename[0] : NULL;
   opts->dump_file = (dump->count > 0) ? dump->filename[0] : NULL;
   opts->load_file = (load->count > 0) ? load->filename[0] : NULL;
+  opts->checkpoint_file =
+      (arg_checkpoint->count > 0) ? arg_checkpoint->filename[0] : NULL;
+  opts->serve_path = (arg_serve->count > 0) ? arg_serve->filename[0] : NULL;
+  opts->cache_dir =
+      (arg_cache_dir->count > 0) ? arg_cache_dir->filename[0] : NULL;
+  opts->cache = (arg_cache_lit->count > 0) || opts->cache_dir != NULL;
+  opts->histograms = (arg_histograms->count > 0);
+  opts->progress = (arg_progress->count > 0);
+  opts->pipe = (arg_pipe->count > 0);
+  /* Shards are named after the output file, they cannot go to stdout. */
+  if (opts->sample_file != NULL && strcmp(opts->sample_file, "-") == 0 &&
+      (opts->nb_samples > 1 || opts->shard_mb > 0 || opts->shard_graphs > 0)) {
+    fprintf(stderr, "[-s|--sample] cannot write shards to the standard "
+                    "output, give a file name.\n");
+    exitcode = EXIT_FAILURE;
+    goto exit;
+  }
 
 exit:
   arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
@@ -238,21 +776,245 @@ exit:
 
 /* Generic command line interface */
 
-int run_cli(int argc, char *argv[], __counter_t counter, __sampler_t sampler,
+/* Checkpoints */
+
+/* Flush to disk the directory containing path, so that a file renamed into
+ * it survives a crash. File systems that cannot sync directories are not
+ * reported. */
+static int _fsync_dir(const char *path) {
+  const char *slash = strrchr(path, '/');
+  const size_t len = slash == NULL ? 1 : slash == path ? 1 : slash - path;
+  char *dir = malloc(len + 1);
+  int fd, error;
+
+  if (slash == NULL)
+    strcpy(dir, ".");
+  else {
+    memcpy(dir, path, len);
+    dir[len] = '\0';
+  }
+  fd = open(dir, O_RDONLY);
+  free(dir);
+  if (fd < 0)
+    return -1;
+  error = fsync(fd) != 0 && errno != EINVAL;
+  error |= close(fd) != 0;
+  return error ? -1 : 0;
+}
+
+/* Save the layers 2 to n of memo, which must be complete, to filename. The
+ * dump is written to a temporary file first, synced to disk and then renamed,
+ * so that a checkpoint is never left half-written, even by a crash. */
+static int save_checkpoint(memo_t memo, int n, const char *filename,
+                           const char *model) {
+  char *tmp = malloc(strlen(filename) + 5);
+  FILE *fd;
+  int error;
+
+  /* A memo_t restricted to its first layers. */
+  memo.N = n;
+
+  sprintf(tmp, "%s.tmp", filename);
+  fd = fopen(tmp, "wb");
+  error = (fd == NULL);
+  if (!error) {
+    error = memo_dump_z(fd, memo, model, NULL) != 0;
+    error |= fflush(fd) != 0;
+    error |= fsync(fileno(fd)) != 0;
+    error |= fclose(fd) != 0;
+    error = error || rename(tmp, filename) != 0;
+    error = error || _fsync_dir(filename) != 0;
+  }
+  free(tmp);
+
+  if (error)
+    fprintf(stderr, "Cannot write checkpoint \"%s\"\n", filename);
+  else
+    fprintf(stderr, "Checkpointed layers 2 to %d to \"%s\"\n", n, filename);
+  return error ? -1 : 0;
+}
+
+/* Load the layers saved in a checkpoint, if it exists. Return the last
+ * complete layer (1 if there is no checkpoint) or -1 if the checkpoint does
+ * not match the table. */
+static int load_checkpoint(memo_t memo, const char *filename,
+                           const char *model) {
+  int N, M, bound, max_m = 0;
+  char file_model[MEMO_Z_MODEL_LEN + 1];
+  FILE *fd = fopen(filename, "rb");
+  const int ok = (fd != NULL) &&
+                 memo_z_header(fd, file_model, &N, &M, &bound) == 0;
+
+  if (fd == NULL)
+    return 1;
+  /* The layers of the checkpoint must have the same shape as ours (their
+   * number of edges is capped by M), the bounds are checked by
+   * memo_load_range. */
+  if (ok) {
+    const int C = min(N - 1, bound);
+    max_m = (C * (C - 1)) / 2 + C * (N - C);
+  }
+  if (!ok || strcmp(file_model, model) != 0 ||
+      min(M, max_m) != min(memo.M, max_m) || N > memo.N ||
+      memo_load_range(memo, fd, 2, N) != 0) {
+    fprintf(stderr,
+            "Invalid checkpoint \"%s\" or computed for other parameters\n",
+            filename);
+    fclose(fd);
+    return -1;
+  }
+  fclose(fd);
+
+  fprintf(stderr, "Resuming from \"%s\": layers 2 to %d are complete\n",
+          filename, N);
+  return N;
+}
+
+/* Fill the table layer by layer, starting after the last checkpointed layer
+ * and saving a checkpoint at least every `every` seconds and at the end. */
+static int checkpointed_fill(memo_t memo, __counter_t counter,
+                             const char *filename, int every,
+                             const char *model) {
+  int n;
+  time_t last = time(NULL);
+  const int done = load_checkpoint(memo, filename, model);
+
+  if (done < 0)
+    return -1;
+
+  for (n = done + 1; n <= memo.N; n++) {
+    memo_fill_layer(memo, counter, n);
+    if (n == memo.N || difftime(time(NULL), last) >= every) {
+      if (save_checkpoint(memo, n, filename, model) != 0)
+        return -1;
+      last = time(NULL);
+    }
+  }
+  return 0;
+}
+
+/* Tell whether a dump of parameters N, M and bound has all the counting
+ * information needed by the command line options, so that it can be used as
+ * is. */
+static int _fits(const cli_options *opts, int N, int M, int bound) {
+  const int B = opts->bound < 0 ? opts->N : opts->bound;
+  const int C = min(opts->N - 1, B);
+  const int max_m = (C * (C - 1)) / 2 + C * (opts->N - C);
+
+  if (opts->N > N || (opts->M < 0 ? max_m : opts->M) > M)
+    return 0;
+  /* See memo_load_range. */
+  return B == bound || opts->N - 1 <= min(B, bound);
+}
+
+/* Check the memory plan of a table against --max-mem and report it. Return
+ * the chosen strategy. */
+static int plan_table(const cli_options *opts, const char *model, int N,
+                      int M, int bound, int all_layers, int on_disk) {
+  static const char *const names[3] = {"dense", "rolling", "out-of-core"};
+  const memo_plan_t plan = memo_plan(model, N, M, bound,
+                                     (size_t)opts->max_mb << 20, all_layers,
+                                     on_disk);
+
+  if (plan.strategy == MEMO_NONE) {
+    fprintf(stderr,
+            "The table does not fit in %d MiB: it has about %.0f cells and "
+            "needs about %.1f MiB with all its layers in memory",
+            opts->max_mb, plan.cells, plan.dense / 1048576.);
+    if (!all_layers)
+      fprintf(stderr, ", %.1f MiB with two layers at a time",
+              plan.rolling / 1048576.);
+    if (on_disk)
+      fprintf(stderr, ", %.1f MiB with its largest layer only",
+              plan.out_of_core / 1048576.);
+    fprintf(stderr, "\n");
+  } else {
+    fprintf(stderr, "Using a %s table (estimated peak %.1f MiB)\n",
+            names[plan.strategy],
+            (plan.strategy == MEMO_DENSE     ? plan.dense
+             : plan.strategy == MEMO_ROLLING ? plan.rolling
+                                             : plan.out_of_core) /
+                1048576.);
+  }
+  return plan.strategy;
+}
+
+/* Report the engine chosen for sampling. Return -1 if it needs more memory
+ * than --max-mem allows. The tables of the recursive method are checked by
+ * plan_table when they are allocated. */
+static int plan_engine(const cli_options *opts, const sampler_plan_t *plan) {
+  const char *name = sampler_engine_name(plan->engine);
+
+  if (!plan->fits && !plan->needs_memo) {
+    fprintf(stderr,
+            "The %s engine does not fit in %d MiB: it needs about %.1f MiB\n",
+            name, opts->max_mb, plan->bytes / 1048576.);
+    return -1;
+  }
+  if (plan->bytes > 0)
+    fprintf(stderr,
+            "Using the %s engine (estimated %.1f MiB of counting "
+            "information)\n",
+            name, plan->bytes / 1048576.);
+  else
+    fprintf(stderr, "Using the %s engine\n", name);
+  return 0;
+}
+
+static void print_z_stats(const char *what, const memo_z_stats *stats) {
+  const double seconds = max(stats->seconds, 1e-6);
+  fprintf(stderr,
+          "%s %lu bytes of compressed counting info (%.1f times smaller than "
+          "the text format) in %.2fs (%.1f MB/s of text)\n",
+          what, stats->size, (double)stats->text_size / stats->size,
+          stats->seconds, stats->text_size / 1e6 / seconds);
+}
+
+int run_cli(int argc, char *argv[], const char *model, __counter_t counter,
+            __sampler_t sampler, __planner_t planner, __csr_writer_t csr,
             long flags) {
 
   int exitcode;
   cli_options opts = {0};
   memo_t memo;
+  timings_t timings;
+  sampler_plan_t plan;
+  /* Whether the layers of memo are computed one at a time by
+   * generic_counter, see --max-mem. */
+  int rolling = 0;
+  /* The dump opened with memo_open_z, if any. */
+  FILE *lazy_fd = NULL;
 
   if ((exitcode = cli_parse(argc, argv, &opts)) != EXIT_SUCCESS)
     return exitcode;
+  timings_init(&timings);
+
+  /* The server and the pipeline build their own tables, as requests
+   * come. */
+  if (opts.serve_path) {
+    return run_server(opts.serve_path, opts.threads, model, counter, sampler,
+                      planner, (size_t)opts.max_mb << 20, flags);
+  }
+  if (opts.pipe) {
+    return run_pipe(opts.threads, model, counter, sampler, planner,
+                    (size_t)opts.max_mb << 20, flags, opts.format);
+  }
+
+  /* Choose how to sample. */
+  plan = planner(opts.N, opts.M, opts.K, opts.bound, opts.nb_samples,
+                 (size_t)opts.max_mb << 20);
+  if (opts.sample_file || opts.stats) {
+    if (plan_engine(&opts, &plan) != 0)
+      return 1;
+    timings.engine = sampler_engine_name(plan.engine);
+  }
 
   /* Load a pre-existing dump or allocate a fresh one. */
   if (opts.load_file) {
     /* FIXME: maybe the logic in this function should be in memo_load? */
 
-    int file_N, file_M, file_bound, r;
+    int file_N, file_M, file_bound, r, compressed;
+    char file_model[MEMO_Z_MODEL_LEN + 1];
     char *line;
     size_t len;
 
@@ -264,40 +1026,168 @@ int run_cli(int argc, char *argv[], __counter_t counter, __sampler_t sampler,
     }
 
     /* Parse of the dump file's header. */
-    line = mygetline(&len, fd);
-    r = sscanf(line, "%d %d %d\n", &file_N, &file_M, &file_bound);
-    if (r < 3) {
-      file_bound = file_N;
+    compressed = (memo_z_header(fd, file_model, &file_N, &file_M,
+                                &file_bound) == 0);
+    if (compressed && strcmp(file_model, model) != 0) {
+      fprintf(stderr, "The dump \"%s\" was computed for %s graphs\n",
+              opts.load_file, file_model);
+      fclose(fd);
+      return 1;
+    } else if (!compressed) {
+      rewind(fd);
+      line = mygetline(&len, fd);
+      r = sscanf(line, "%d %d %d\n", &file_N, &file_M, &file_bound);
+      if (r < 3) {
+        file_bound = file_N;
+      }
+      free(line);
+    }
+
+    /* When the dump is large enough and computed for our bound, open it as
+     * is: the layers we need are read the first time they are accessed. */
+    if (compressed && !opts.dump_file && !opts.checkpoint_file &&
+        _fits(&opts, file_N, file_M, file_bound)) {
+      /* By default, --max-mem also caps the loaded layers. */
+      const int cache_mb = opts.cache_mb > 0 ? opts.cache_mb : opts.max_mb;
+      if (opts.max_mb > 0 && plan_table(&opts, model, opts.N, opts.M,
+                                        opts.bound, 1, 1) == MEMO_NONE) {
+        fclose(fd);
+        return 1;
+      }
+      if (memo_open_z(&memo, fd, opts.M, (size_t)cache_mb << 20) != 0) {
+        fprintf(stderr, "Invalid compressed dump \"%s\"\n", opts.load_file);
+        fclose(fd);
+        return 1;
+      }
+      lazy_fd = fd;
+      goto loaded;
     }
 
     /* Allocate enough space for our  */
     {
-      const int N = max(opts.N, file_N);
-      const int bound = opts.bound < 0 ? N : max(opts.bound, file_bound);
+      /* Compressed dumps can be loaded partially, only load what we need. */
+      const int N =
+          (compressed && !opts.dump_file) ? opts.N : max(opts.N, file_N);
+      /* Compressed dumps computed for another bound are rejected. */
+      const int bound = opts.bound < 0 ? N
+                        : compressed   ? opts.bound
+                                       : max(opts.bound, file_bound);
       const int C = min(N - 1, bound);
       const int M = opts.M < 0 ? max(file_M, (C * (C - 1)) / 2 + C * (N - C))
                                : max(opts.M, file_M);
+      if (opts.max_mb > 0 &&
+          plan_table(&opts, model, N, M, bound, 1, 0) == MEMO_NONE) {
+        fclose(fd);
+        return 1;
+      }
       memo = memo_alloc(N, M, bound);
     }
 
     /* Parse the rest of the file. */
-    memo_load(memo, fd);
+    if (compressed) {
+      memo_z_stats stats;
+      if ((memo.N < file_N) ? memo_load_range(memo, fd, 2, memo.N)
+                            : memo_load_z(memo, fd, &stats)) {
+        fprintf(stderr,
+                "Invalid compressed dump \"%s\" or computed for another "
+                "bound\n",
+                opts.load_file);
+        fclose(fd);
+        return 1;
+      }
+      if (memo.N >= file_N)
+        print_z_stats("Loaded", &stats);
+    } else if (opts.threads > 1) {
+      if (memo_load_parallel(memo, fd, opts.threads) != 0) {
+        fprintf(stderr, "Invalid dump \"%s\"\n", opts.load_file);
+        fclose(fd);
+        return 1;
+      }
+    } else if (memo_load(memo, fd) != 0) {
+      fprintf(stderr, "Invalid dump \"%s\"\n", opts.load_file);
+      fclose(fd);
+      return 1;
+    }
 
     fclose(fd);
+  loaded:
+    timings_end(&timings, PHASE_LOAD);
+  } else if (!opts.count && !opts.query && !opts.dump_file &&
+             !opts.checkpoint_file && !plan.needs_memo) {
+    /* The sampler does not need the table, don't allocate it. */
+    memo = memo_alloc(0, 0, opts.bound);
+    timings_end(&timings, PHASE_ALLOC);
+  } else if (opts.cache) {
+    int status;
+    if (opts.max_mb > 0 && plan_table(&opts, model, opts.N, opts.M,
+                                      opts.bound, 1, 0) == MEMO_NONE)
+      return 1;
+    status = memo_cache_get(&memo, opts.cache_dir, model, counter,
+                                      opts.N, opts.M, opts.bound);
+    if (status == 1)
+      fprintf(stderr, "Loaded the table from the cache\n");
+    else if (status == 0)
+      fprintf(stderr, "Stored the table in the cache\n");
+    else
+      fprintf(stderr, "Cannot use the cache, the table was not stored\n");
+    timings_end(&timings, PHASE_LOAD);
   } else {
     const int C = min(opts.N - 1, (opts.bound < 0 ? opts.N : opts.bound));
     const int M = opts.M < 0 ? (C * (C - 1)) / 2 + C * (opts.N - C) : opts.M;
-    memo = memo_alloc(opts.N, M, opts.bound);
+    /* Counting the graphs of each size is the only use of the table that
+     * does not need all its layers at once. */
+    const int all_layers = !opts.count || opts.query || opts.sample_file ||
+                           opts.stats || opts.dump_file ||
+                           opts.checkpoint_file;
+    if (opts.max_mb > 0) {
+      const int strategy =
+          plan_table(&opts, model, opts.N, M, opts.bound, all_layers, 0);
+      if (strategy == MEMO_NONE)
+        return 1;
+      rolling = (strategy == MEMO_ROLLING);
+    }
+    memo = rolling ? memo_alloc_empty(opts.N, M, opts.bound)
+                   : memo_alloc(opts.N, M, opts.bound);
+    timings_end(&timings, PHASE_ALLOC);
+  }
+
+  /* Fill the table in a resumable way. */
+  if (opts.checkpoint_file &&
+      checkpointed_fill(memo, counter, opts.checkpoint_file,
+                        opts.checkpoint_every, model) != 0) {
+    return 1;
   }
 
+  /* Otherwise, the cells are computed when they are first needed, except
+   * with --progress. Queries only need a few of them. */
+  if (opts.progress && memo.lazy == NULL && !rolling &&
+      (opts.count || opts.stats || opts.sample_file || opts.dump_file)) {
+    progress_fill(memo, counter, 2);
+  }
+  timings_end(&timings, PHASE_COUNT);
+
   /* Count. */
   if (opts.count) {
-    generic_counter(counter, memo, opts.N, opts.M, opts.bound);
+    generic_counter(counter, memo, opts.N, opts.M, opts.bound, rolling,
+                    opts.exact);
+  }
+  if (opts.query) {
+    generic_query(counter, memo, opts.query_n, opts.query_m, opts.query_k,
+                  opts.bound);
   }
+  timings_end(&timings, PHASE_COUNT);
 
-  if (opts.sample_file) {
-    generic_sampler(opts.sample_file, memo, sampler, flags, opts.N, opts.M,
-                    opts.bound);
+  if (opts.stats &&
+      generic_stats(&opts, memo, counter, sampler, &plan) !=
+          EXIT_SUCCESS) {
+    return 1;
+  }
+  timings_end(&timings, PHASE_SAMPLE);
+
+  if (opts.sample_file &&
+      generic_sampler(&opts, memo, counter, sampler, csr, &plan, flags,
+                      &timings) != EXIT_SUCCESS) {
+    return 1;
   }
 
   /* Dump the memoisation table if asked to. */
@@ -307,9 +1197,29 @@ int run_cli(int argc, char *argv[], __counter_t counter, __sampler_t sampler,
       fprintf(stderr, "Cannot open file \"%s\"\n", opts.dump_file);
       return 1;
     }
-    memo_dump(fd, memo);
-    return 0;
+    if (opts.compress) {
+      memo_z_stats stats;
+      if (memo_dump_z(fd, memo, model, &stats) != 0) {
+        fprintf(stderr, "Error while writing to file \"%s\"\n",
+                opts.dump_file);
+        return 1;
+      }
+      print_z_stats("Dumped", &stats);
+    } else if (opts.threads > 1) {
+      memo_dump_parallel(fd, memo, opts.threads);
+    } else {
+      memo_dump(fd, memo);
+    }
+    fclose(fd);
+    timings_end(&timings, PHASE_DUMP);
   }
 
+  if (opts.timings)
+    timings_print(stderr, &timings, opts.timings == 2);
+
+  if (lazy_fd != NULL) {
+    memo_free(memo);
+    fclose(lazy_fd);
+  }
   return 0;
 }
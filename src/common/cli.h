@@ -21,10 +21,44 @@
 #include "../../includes/common.h" /* randdag_t */
 #include <gmp.h>                   /* gmp_randstate_t */
 
-typedef randdag_t (*__sampler_t)(gmp_randstate_t, memo_t, int n, int m,
-                                 int bound);
+/* Negative values of m and k mean any number of edges and sources. The
+ * engine is chosen by the planner (e.g. doag_unif_engine and doag_plan). */
+typedef randdag_t (*__sampler_t)(gmp_randstate_t, memo_t, int engine, int n,
+                                 int m, int k, int bound);
 typedef mpz_t *(*__counter_t)(memo_t, int n, int m, int k, int bound);
+typedef sampler_plan_t (*__planner_t)(int n, int m, int k, int bound,
+                                      unsigned long count, size_t max_bytes);
+/* Draw the graph of the rejection engine straight to a file in CSR format,
+ * see doag_unif_n_csr. Return 0 on success and -1 on errors. */
+typedef int (*__csr_writer_t)(gmp_randstate_t, int n, const char *filename);
 
-int run_cli(int argc, char *argv[], __counter_t, __sampler_t, long flags);
+/* Draw the i-th graph of a run from the i-th stream of `seed` (see
+ * randdag_seed_stream) with the given engine. If w is not NULL, the
+ * parameters n, m and k are first selected from the window w, computed for
+ * them by window_alloc, which saves recomputing the marginal counts at each
+ * sample. */
+randdag_t cli_sample(__sampler_t, int engine, gmp_randstate_t, memo_t,
+                     const window_t *w, int n, int m, int k, int bound,
+                     unsigned long seed, unsigned long i);
+
+/* The name of the model (e.g. "doag") is recorded in the compressed dumps and
+ * checked when loading them. If the model has a streaming CSR writer (NULL
+ * otherwise), a single graph of the rejection engine written to a file in
+ * CSR format is written by it and never built in memory. */
+int run_cli(int argc, char *argv[], const char *model, __counter_t,
+            __sampler_t, __planner_t, __csr_writer_t, long flags);
+
+/* Serve sampling requests on the Unix domain socket `path` with a pool of
+ * `threads` workers, rejecting those needing more than max_bytes bytes (if
+ * non-zero), see server.c. Only return on errors. */
+int run_server(const char *path, int threads, const char *model, __counter_t,
+               __sampler_t, __planner_t, size_t max_bytes, long flags);
+
+/* Run the sampling jobs read from the standard input with `threads` workers,
+ * writing the graphs in the given format, see server.c. The jobs needing more
+ * than max_bytes bytes (if non-zero) fail. Return EXIT_FAILURE if a job
+ * failed. */
+int run_pipe(int threads, const char *model, __counter_t, __sampler_t,
+             __planner_t, size_t max_bytes, long flags, int format);
 
 #endif
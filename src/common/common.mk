@@ -1,11 +1,71 @@
-$(BUILD)common/graphs.o: src/common/graphs.c includes/common.h
+$(BUILD)common/graphs.o: src/common/graphs.c src/common/writer.h includes/common.h
 	@mkdir -p "$(BUILD)/common"
 	$(CC) $(CFLAGS) -o $@ -c src/common/graphs.c
 
-$(BUILD)common/memo.o: src/common/memo.c includes/common.h
+$(BUILD)common/memo.o: src/common/memo.c src/common/memo.h includes/common.h
 	@mkdir -p "$(BUILD)/common"
 	$(CC) $(CFLAGS) -o $@ -c src/common/memo.c
 
-$(BUILD)common/cli.o: src/common/cli.c includes/common.h
+$(BUILD)common/cli.o: src/common/cli.c src/common/cli.h src/common/memo.h src/common/progress.h src/common/small.h includes/common.h
 	@mkdir -p "$(BUILD)/common"
 	$(CC) $(CFLAGS) -o $@ -c src/common/cli.c
+
+$(BUILD)common/server.o: src/common/server.c src/common/cli.h src/common/memo.h src/common/progress.h src/common/writer.h includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/server.c
+
+$(BUILD)common/progress.o: src/common/progress.c src/common/progress.h includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/progress.c
+
+$(BUILD)common/window.o: src/common/window.c includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/window.c
+
+$(BUILD)common/rng.o: src/common/rng.c includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/rng.c
+
+$(BUILD)common/small.o: src/common/small.c src/common/small.h includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/small.c
+
+$(BUILD)common/writer.o: src/common/writer.c src/common/writer.h includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/writer.c
+
+$(BUILD)common/memo_z.o: src/common/memo_z.c src/common/lz.h src/common/memo.h src/common/writer.h includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/memo_z.c
+
+$(BUILD)common/memo_cache.o: src/common/memo_cache.c includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/memo_cache.c
+
+$(BUILD)common/memo_plan.o: src/common/memo_plan.c src/common/memo.h includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/memo_plan.c
+
+$(BUILD)common/lz.o: src/common/lz.c src/common/lz.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/lz.c
+
+$(BUILD)common/memo_par.o: src/common/memo_par.c includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/memo_par.c
+
+$(BUILD)common/shards.o: src/common/shards.c src/common/writer.h includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/shards.c
+
+$(BUILD)common/reader.o: src/common/reader.c includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/reader.c
+
+$(BUILD)common/mapbuf.o: src/common/mapbuf.c src/common/mapbuf.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/mapbuf.c
+
+$(BUILD)common/stats.o: src/common/stats.c includes/common.h
+	@mkdir -p "$(BUILD)/common"
+	$(CC) $(CFLAGS) -o $@ -c src/common/stats.c
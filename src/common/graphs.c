@@ -15,9 +15,11 @@
    You should have received a copy of the GNU General Public License
    along with this program.  If not, see <https://www.gnu.org/licenses/>. */
 
-#include <malloc.h> /* calloc */
+#include <malloc.h> /* calloc, malloc, free */
+#include <string.h> /* memcpy */
 
 #include "../../includes/common.h"
+#include "writer.h"
 
 randdag_t randdag_alloc(int N) {
   randdag_vertex *v = calloc(N, sizeof(randdag_vertex));
@@ -36,35 +38,228 @@ void randdag_free(randdag_t g) {
   free(g.v);
 }
 
-void randdag_to_dot(FILE *fd, const randdag_t g, unsigned int flags) {
-  int i;
+/* --- Graphviz output ---------------------------------------------------- */
+
+/* Append a string literal. */
+#define _write_str(w, s) writer_bytes(w, s, sizeof(s) - 1)
+
+/* Preformatted ", n<id>" strings, indexed by id - min_id. */
+typedef struct {
+  int min_id;
+  char (*str)[16];
+  unsigned char *len;
+} _dot_ids;
+
+/* Write the decimal representation of x to s, which must have room for 11
+ * characters, and return its length. */
+static int _format_int(char *s, int x) {
+  char digits[10];
+  unsigned int u = x < 0 ? -(unsigned int)x : (unsigned int)x;
+  int i = 10, len = 0;
+
+  do {
+    digits[--i] = '0' + (char)(u % 10);
+    u /= 10;
+  } while (u > 0);
+
+  if (x < 0)
+    s[len++] = '-';
+  memcpy(s + len, digits + i, 10 - i);
+  return len + 10 - i;
+}
+
+/* Return 0 if the ids of g span a too large range for a table to be worth it.
+ */
+static int _dot_ids_init(_dot_ids *ids, const randdag_t g) {
+  int i, max_id = 0;
+
+  ids->min_id = 0;
+  for (i = 0; i < g.N; i++) {
+    if (i == 0 || g.v[i].id < ids->min_id)
+      ids->min_id = g.v[i].id;
+    if (i == 0 || g.v[i].id > max_id)
+      max_id = g.v[i].id;
+  }
+  if (g.N == 0 || max_id - ids->min_id >= 2 * g.N)
+    return 0;
+
+  ids->str = malloc((max_id - ids->min_id + 1) * sizeof(char[16]));
+  ids->len = malloc(max_id - ids->min_id + 1);
+  for (i = 0; i <= max_id - ids->min_id; i++) {
+    memcpy(ids->str[i], ", n", 3);
+    ids->len[i] =
+        (unsigned char)(3 + _format_int(ids->str[i] + 3, ids->min_id + i));
+  }
+
+  return 1;
+}
 
-  fprintf(fd, "digraph G {\n  rankdir = \"TB\"\n");
+/* The output is built in the buffer of the writer with hand-rolled integer
+ * formatting instead of one fprintf call per edge, whose cost is dominated by
+ * the parsing of the format string and by the locking of the FILE. The
+ * out-neighbours, which make most of the output, are copied from a table of
+ * preformatted strings. */
+static void _write_dot(writer_t *w, const randdag_t g, unsigned int flags) {
+  int i, j;
+  _dot_ids ids;
+  const int use_table = _dot_ids_init(&ids, g);
+
+  _write_str(w, "digraph G {\n  rankdir = \"TB\"\n");
   if (flags & RD_DOT_ORDERING) {
-    fprintf(fd, "  ordering = \"out\"\n");
+    _write_str(w, "  ordering = \"out\"\n");
   }
-  fprintf(fd, "  edge [arrowhead=none, penwidth=2]\n");
+  _write_str(w, "  edge [arrowhead=none, penwidth=2]\n");
   if (!(flags & RD_DOT_LABELLED)) {
-    fprintf(fd, "  node [shape=circle, label=\"\", color=black, style=filled, "
-                "width=.5]\n");
+    _write_str(w, "  node [shape=circle, label=\"\", color=black, "
+                  "style=filled, width=.5]\n");
   }
 
   for (i = 0; i < g.N; i++) {
-    int j;
     const randdag_vertex u = g.v[i];
 
-    fprintf(fd, "  n%d", u.id);
-    if (flags & RD_DOT_LABELLED)
-      fprintf(fd, " [label=\"%d\"]", u.id);
-    fprintf(fd, "\n");
+    _write_str(w, "  n");
+    writer_int(w, u.id);
+    if (flags & RD_DOT_LABELLED) {
+      _write_str(w, " [label=\"");
+      writer_int(w, u.id);
+      _write_str(w, "\"]");
+    }
+    writer_char(w, '\n');
     if (u.out_degree > 0) {
-      fprintf(fd, "  n%d -> {n%d", u.id, u.out_edges[0].id);
+      _write_str(w, "  n");
+      writer_int(w, u.id);
+      _write_str(w, " -> {n");
+      writer_int(w, u.out_edges[0].id);
       for (j = 1; j < u.out_degree; j++) {
-        fprintf(fd, ", n%d", u.out_edges[j].id);
+        if (use_table) {
+          const int id = u.out_edges[j].id - ids.min_id;
+          writer_reserve(w, 16);
+          memcpy(w->buf + w->len, ids.str[id], 16);
+          w->len += ids.len[id];
+        } else {
+          _write_str(w, ", n");
+          writer_int(w, u.out_edges[j].id);
+        }
       }
-      fprintf(fd, "}\n");
+      _write_str(w, "}\n");
+    }
+  }
+
+  _write_str(w, "}\n");
+
+  if (use_table) {
+    free(ids.str);
+    free(ids.len);
+  }
+}
+
+void randdag_to_dot(FILE *fd, const randdag_t g, unsigned int flags) {
+  writer_t w;
+
+  writer_init(&w, fd);
+  _write_dot(&w, g, flags);
+  writer_close(&w);
+}
+
+/* --- Other output formats ------------------------------------------------ */
+
+static void _write_edges(writer_t *w, const randdag_t g) {
+  int i, j;
+
+  for (i = 0; i < g.N; i++) {
+    const randdag_vertex u = g.v[i];
+    for (j = 0; j < u.out_degree; j++) {
+      writer_uint(w, u.id);
+      writer_char(w, ' ');
+      writer_uint(w, u.out_edges[j].id);
+      writer_char(w, '\n');
+    }
+  }
+}
+
+/* Write the header of the binary formats and return the smallest vertex id. */
+static int _write_header(writer_t *w, const randdag_t g, const char *magic) {
+  int i, min_id = 0;
+  unsigned long M = 0;
+
+  for (i = 0; i < g.N; i++) {
+    if (i == 0 || g.v[i].id < min_id)
+      min_id = g.v[i].id;
+    M += g.v[i].out_degree;
+  }
+
+  writer_bytes(w, magic, 4);
+  writer_u32(w, 1);
+  writer_u64(w, g.N);
+  writer_u64(w, M);
+
+  return min_id;
+}
+
+static void _write_bin_edges(writer_t *w, const randdag_t g) {
+  int i, j;
+  const int min_id = _write_header(w, g, "RDEL");
+
+  for (i = 0; i < g.N; i++) {
+    const randdag_vertex u = g.v[i];
+    for (j = 0; j < u.out_degree; j++) {
+      writer_u32(w, u.id - min_id);
+      writer_u32(w, u.out_edges[j].id - min_id);
     }
   }
+}
+
+static void _write_csr(writer_t *w, const randdag_t g) {
+  int i, j;
+  unsigned long offset;
+  const int min_id = _write_header(w, g, "RDCS");
+  /* pos[i] is the position in g.v of the vertex numbered i. */
+  int *pos = malloc(g.N * sizeof(int));
+
+  for (i = 0; i < g.N; i++)
+    pos[g.v[i].id - min_id] = i;
+
+  offset = 0;
+  writer_u64(w, offset);
+  for (i = 0; i < g.N; i++) {
+    offset += g.v[pos[i]].out_degree;
+    writer_u64(w, offset);
+  }
+
+  for (i = 0; i < g.N; i++) {
+    const randdag_vertex u = g.v[pos[i]];
+    for (j = 0; j < u.out_degree; j++)
+      writer_u32(w, u.out_edges[j].id - min_id);
+  }
+
+  free(pos);
+}
+
+void randdag_write_w(writer_t *w, const randdag_t g, int format,
+                     unsigned int flags) {
+  switch (format) {
+  case RD_FMT_DOT:
+    _write_dot(w, g, flags);
+    break;
+  case RD_FMT_EDGES:
+    _write_edges(w, g);
+    break;
+  case RD_FMT_BIN_EDGES:
+    _write_bin_edges(w, g);
+    break;
+  case RD_FMT_CSR:
+    _write_csr(w, g);
+    break;
+  default:
+    fprintf(stderr, "Unknown output format: %d\n", format);
+    w->error = 1;
+  }
+}
+
+int randdag_write(FILE *fd, const randdag_t g, int format, unsigned int flags) {
+  writer_t w;
 
-  fprintf(fd, "}\n");
+  writer_init(&w, fd);
+  randdag_write_w(&w, g, format, flags);
+  return writer_close(&w);
 }
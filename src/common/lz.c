@@ -0,0 +1,177 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#include <malloc.h> /* calloc, free */
+#include <string.h> /* memcpy */
+
+#include "lz.h"
+
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+#define HASH_BITS 14
+/* The last bytes of the input are always emitted as literals, which allows to
+ * read 4 bytes ahead without bound checks. */
+#define LAST_LITERALS 5
+
+static unsigned long _read32(const unsigned char *p) {
+  return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+         ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static unsigned int _hash(const unsigned char *p) {
+  return (unsigned int)(((_read32(p) * 2654435761UL) & 0xffffffffUL) >>
+                        (32 - HASH_BITS));
+}
+
+/* Write a length continuation. Return the new output position or NULL if it
+ * would overflow dst_end. */
+static unsigned char *_put_len(unsigned char *o, const unsigned char *o_end,
+                               size_t len) {
+  while (len >= 255) {
+    if (o >= o_end)
+      return NULL;
+    *o++ = 255;
+    len -= 255;
+  }
+  if (o >= o_end)
+    return NULL;
+  *o++ = (unsigned char)len;
+  return o;
+}
+
+/* Emit a (literals, match) pair. A match_len of 0 means no match. */
+static unsigned char *_put_seq(unsigned char *o, const unsigned char *o_end,
+                               const unsigned char *lit, size_t lit_len,
+                               size_t offset, size_t match_len) {
+  unsigned char *token = o++;
+  const size_t ml = match_len ? match_len - MIN_MATCH : 0;
+
+  if (o > o_end)
+    return NULL;
+  *token = (unsigned char)(((lit_len < 15 ? lit_len : 15) << 4) |
+                           (ml < 15 ? ml : 15));
+  if (lit_len >= 15 && (o = _put_len(o, o_end, lit_len - 15)) == NULL)
+    return NULL;
+  if (o + lit_len > o_end)
+    return NULL;
+  memcpy(o, lit, lit_len);
+  o += lit_len;
+
+  if (match_len) {
+    if (o + 2 > o_end)
+      return NULL;
+    *o++ = (unsigned char)(offset & 0xff);
+    *o++ = (unsigned char)(offset >> 8);
+    if (ml >= 15 && (o = _put_len(o, o_end, ml - 15)) == NULL)
+      return NULL;
+  }
+  return o;
+}
+
+size_t lz_compress(const unsigned char *src, size_t len, unsigned char *dst) {
+  size_t i, anchor;
+  unsigned char *o = dst;
+  const unsigned char *o_end = dst + len;
+  const size_t match_end =
+      (len > LAST_LITERALS + MIN_MATCH) ? len - LAST_LITERALS - MIN_MATCH : 0;
+  /* Last position + 1 at which each hash was seen, 0 meaning never. */
+  size_t *table = calloc(1 << HASH_BITS, sizeof(size_t));
+
+  i = anchor = 0;
+
+  while (i < match_end) {
+    const unsigned int h = _hash(src + i);
+    const size_t ref = table[h];
+    table[h] = i + 1;
+
+    if (ref > 0 && i - (ref - 1) <= MAX_OFFSET &&
+        _read32(src + ref - 1) == _read32(src + i)) {
+      size_t match = MIN_MATCH;
+      while (i + match < len - LAST_LITERALS &&
+             src[ref - 1 + match] == src[i + match])
+        match++;
+      o = _put_seq(o, o_end, src + anchor, i - anchor, i - (ref - 1), match);
+      if (o == NULL)
+        break;
+      i += match;
+      anchor = i;
+    } else {
+      i++;
+    }
+  }
+
+  free(table);
+  if (o != NULL)
+    o = _put_seq(o, o_end, src + anchor, len - anchor, 0, 0);
+  if (o == NULL || o >= o_end)
+    return 0;
+  return o - dst;
+}
+
+/* Read a length continuation. */
+static int _get_len(const unsigned char **i, const unsigned char *i_end,
+                    size_t *len) {
+  unsigned char b;
+  do {
+    if (*i >= i_end)
+      return -1;
+    b = *(*i)++;
+    *len += b;
+  } while (b == 255);
+  return 0;
+}
+
+int lz_decompress(const unsigned char *src, size_t len, unsigned char *dst,
+                  size_t out_len) {
+  const unsigned char *i = src, *i_end = src + len;
+  unsigned char *o = dst, *o_end = dst + out_len;
+
+  while (i < i_end) {
+    const unsigned char token = *i++;
+    size_t lit_len = token >> 4, match_len = token & 15, offset;
+
+    if (lit_len == 15 && _get_len(&i, i_end, &lit_len))
+      return -1;
+    if (lit_len > (size_t)(i_end - i) || lit_len > (size_t)(o_end - o))
+      return -1;
+    memcpy(o, i, lit_len);
+    o += lit_len;
+    i += lit_len;
+
+    /* The last pair has no match. */
+    if (i == i_end)
+      break;
+
+    if (i_end - i < 2)
+      return -1;
+    offset = i[0] | ((size_t)i[1] << 8);
+    i += 2;
+    if (match_len == 15 && _get_len(&i, i_end, &match_len))
+      return -1;
+    match_len += MIN_MATCH;
+    if (offset == 0 || offset > (size_t)(o - dst) ||
+        match_len > (size_t)(o_end - o))
+      return -1;
+    /* Byte by byte: the match may overlap its own output. */
+    while (match_len--) {
+      *o = *(o - offset);
+      o++;
+    }
+  }
+
+  return (o == o_end) ? 0 : -1;
+}
@@ -0,0 +1,43 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef _RANDDAG_LZ_H
+#define _RANDDAG_LZ_H
+
+/* A small general-purpose LZ77 compressor, in the spirit of LZ4, used as the
+ * last stage of the compressed memo dumps.
+ *
+ * The compressed stream is a sequence of (literals, match) pairs. Each pair
+ * starts with a token byte holding the number of literals in its 4 high bits
+ * and the length of the match minus 4 in its 4 low bits, the value 15 meaning
+ * that the length continues on the next bytes (a sequence of 255 bytes ended
+ * by a byte smaller than 255). The literals follow, then the offset of the
+ * match over 2 bytes (little-endian) and the continuation of its length. The
+ * last pair has no match. */
+
+#include <stddef.h> /* size_t */
+
+/* Compress src[0..len) into dst, which must have room for len bytes. Return
+ * the size of the compressed data, or 0 if it is not smaller than len. */
+size_t lz_compress(const unsigned char *src, size_t len, unsigned char *dst);
+
+/* Decompress src[0..len) into dst[0..out_len). Return 0 on success and -1 if
+ * the input is malformed or does not decompress to exactly out_len bytes. */
+int lz_decompress(const unsigned char *src, size_t len, unsigned char *dst,
+                  size_t out_len);
+
+#endif
@@ -0,0 +1,67 @@
+#define _POSIX_C_SOURCE 200809L
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#include <fcntl.h>    /* open */
+#include <sys/mman.h> /* mmap, munmap */
+#include <unistd.h>   /* ftruncate, close */
+
+#include "mapbuf.h"
+
+/* Initial size of the region, it is doubled when it is too small. */
+#define MAPBUF_MIN (1 << 20)
+
+int mapbuf_open(mapbuf_t *b, const char *filename) {
+  b->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  b->p = NULL;
+  b->cap = 0;
+  return b->fd < 0 ? -1 : 0;
+}
+
+int mapbuf_reserve(mapbuf_t *b, size_t len) {
+  size_t cap = b->cap ? b->cap : MAPBUF_MIN;
+  void *p;
+
+  if (len <= b->cap)
+    return 0;
+  while (cap < len)
+    cap *= 2;
+
+  /* The content is in the file: unmap, grow the file and map it again. */
+  if (b->p != NULL)
+    munmap(b->p, b->cap);
+  b->p = NULL;
+  b->cap = 0;
+  if (ftruncate(b->fd, cap) != 0)
+    return -1;
+  p = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_SHARED, b->fd, 0);
+  if (p == MAP_FAILED)
+    return -1;
+  b->p = p;
+  b->cap = cap;
+  return 0;
+}
+
+int mapbuf_close(mapbuf_t *b, size_t len) {
+  int error = 0;
+
+  if (b->p != NULL)
+    error |= munmap(b->p, b->cap) != 0;
+  error |= ftruncate(b->fd, len) != 0;
+  error |= close(b->fd) != 0;
+  return error ? -1 : 0;
+}
@@ -0,0 +1,49 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef _RANDDAG_MAPBUF_H
+#define _RANDDAG_MAPBUF_H
+
+/* File-backed output buffers.
+ *
+ * A mapbuf is a region of memory mapped onto a file, which grows on demand
+ * by extending the file. It lets the producers of very large graphs write
+ * their output in place, with the kernel paging it out to the file, instead
+ * of building it in memory first. This relies on POSIX file mapping. */
+
+#include <stddef.h> /* size_t */
+
+typedef struct {
+  int fd;
+  /* The mapped region and its size. */
+  unsigned char *p;
+  size_t cap;
+} mapbuf_t;
+
+/* Create (or truncate) a file and map it. Return -1 on error. */
+int mapbuf_open(mapbuf_t *, const char *filename);
+
+/* Make the first len bytes of the region available, growing the file and
+ * remapping the region if needed (so that former values of p are
+ * invalidated). Return -1 on error. */
+int mapbuf_reserve(mapbuf_t *, size_t len);
+
+/* Truncate the file to its first len bytes, unmap it and close it. Return -1
+ * on error. */
+int mapbuf_close(mapbuf_t *, size_t len);
+
+#endif
@@ -21,12 +21,52 @@
 #include <gmp.h>
 
 #include "../../includes/common.h"
+#include "memo.h"
+#include "small.h"
 
 #define min(x, y) (((x) < (y)) ? (x) : (y))
 
+mpz_t **memo_layer_alloc(int n, int M, int bound) {
+  int m, k;
+  mpz_t **layer = calloc(n, sizeof(mpz_t *));
+
+  for (k = 1; k <= n; k++) {
+    const int C = min(bound, n - k);
+    const int max_m = min((C - 1) * C / 2 + C * (n - C), M);
+    layer[k - 1] = calloc(max_m + 1, sizeof(mpz_t));
+
+    for (m = 0; m <= max_m; m++) {
+      mpz_init(layer[k - 1][m]);
+    }
+  }
+
+  return layer;
+}
+
+void memo_layer_free(mpz_t **layer, int n, int M, int bound) {
+  int m, k;
+
+  for (k = 1; k <= n; k++) {
+    const int C = min(n - k, bound);
+    const int max_m = min((C - 1) * C / 2 + C * (n - C), M);
+    for (m = 0; m <= max_m; m++) {
+      mpz_clear(layer[k - 1][m]);
+    }
+    free(layer[k - 1]);
+  }
+  free(layer);
+}
+
 memo_t memo_alloc(int N, int M, int bound) {
-  int n, m, k;
-  mpz_t ***vals;
+  int n;
+  memo_t memo = memo_alloc_empty(N, M, bound);
+
+  for (n = 2; n <= N; n++)
+    memo.vals[n - 2] = memo_layer_alloc(n, memo.M, memo.bound);
+  return memo;
+}
+
+memo_t memo_alloc_empty(int N, int M, int bound) {
   memo_t memo;
 
   /* Negative bounds means unbounded. */
@@ -36,24 +76,107 @@ memo_t memo_alloc(int N, int M, int bound) {
   if (M < 0)
     M = N * (N - 1) / 2;
 
-  vals = calloc(N - 1, sizeof(mpz_t **));
-  for (n = 2; n <= N; n++) {
-    vals[n - 2] = calloc(n, sizeof(mpz_t *));
+  memo.vals = calloc(N > 1 ? N - 1 : 1, sizeof(mpz_t **));
+  memo.N = N;
+  memo.M = M;
+  memo.bound = bound;
+  memo.zero = malloc(sizeof(mpz_t));
+  memo.one = malloc(sizeof(mpz_t));
+  mpz_init_set_ui(*memo.one, 1);
+  mpz_init_set_ui(*memo.zero, 0);
+  memo.small = small_table_new();
+  memo.lazy = NULL;
 
-    for (k = 1; k <= n; k++) {
-      const int C = min(bound, n - k);
-      const int max_m = min((C - 1) * C / 2 + C * (n - C), M);
-      vals[n - 2][k - 1] = calloc(max_m + 1, sizeof(mpz_t));
+  return memo;
+}
 
-      for (m = 0; m <= max_m; m++) {
-        mpz_init(vals[n - 2][k - 1][m]);
-      }
+void memo_free(memo_t memo) {
+  int n;
+
+  if (memo.lazy != NULL) {
+    /* The layers are owned by the loading state. */
+    memo_lazy_free(memo);
+  } else {
+    for (n = 2; n <= memo.N; n++) {
+      if (memo.vals[n - 2] != NULL)
+        memo_layer_free(memo.vals[n - 2], n, memo.M, memo.bound);
+    }
+  }
+
+  free(memo.vals);
+  small_table_free(memo.small);
+  mpz_clear(*memo.zero);
+  mpz_clear(*memo.one);
+  free(memo.zero);
+  free(memo.one);
+}
+
+memo_t memo_extend(memo_t memo, int N, int M, int bound) {
+  int n;
+  void *small;
+  memo_t res = memo_alloc_empty(N, M, bound);
+
+  /* Only the new layers are allocated. */
+  for (n = 2; n <= memo.N; n++)
+    res.vals[n - 2] = memo.vals[n - 2];
+  for (n = memo.N < 2 ? 2 : memo.N + 1; n <= N; n++)
+    res.vals[n - 2] = memo_layer_alloc(n, res.M, res.bound);
+  small = res.small;
+  res.small = memo.small;
+
+  free(memo.vals);
+  small_table_free(small);
+  mpz_clear(*memo.zero);
+  mpz_clear(*memo.one);
+  free(memo.zero);
+  free(memo.one);
+  return res;
+}
+
+void memo_fill_layer(memo_t memo, randdag_counter_t count, int n) {
+  int m, k;
+
+  for (k = 1; k <= n; k++) {
+    const int C = min(memo.bound, n - k);
+    const int max_m = min((C - 1) * C / 2 + C * (n - C), memo.M);
+    for (m = n - k; m <= max_m; m++)
+      count(memo, n, m, k, memo.bound);
+  }
+}
+
+void memo_fill_layer_total(memo_t memo, randdag_counter_t count, int n, int M,
+                           mpz_t total) {
+  int m, k;
+
+  mpz_set_ui(total, 0);
+  for (k = 1; k <= n; k++) {
+    const int C = min(memo.bound, n - k);
+    const int max_m = min((C - 1) * C / 2 + C * (n - C), memo.M);
+    for (m = n - k; m <= max_m; m++) {
+      mpz_t *x = count(memo, n, m, k, memo.bound);
+      if (M < 0 || m <= M)
+        mpz_add(total, total, *x);
+    }
+  }
+}
+
+memo_nk_t memo_nk_alloc(int N, int bound) {
+  int n, k;
+  memo_nk_t memo;
+
+  /* Negative bounds means unbounded. */
+  if (bound < 0 || bound > N)
+    bound = N;
+
+  memo.vals = calloc(N > 1 ? N - 1 : 1, sizeof(mpz_t *));
+  for (n = 2; n <= N; n++) {
+    memo.vals[n - 2] = calloc(n, sizeof(mpz_t));
+    for (k = 1; k <= n; k++) {
+      mpz_init(memo.vals[n - 2][k - 1]);
     }
   }
 
-  memo.vals = vals;
   memo.N = N;
-  memo.M = M;
   memo.bound = bound;
   memo.zero = malloc(sizeof(mpz_t));
   memo.one = malloc(sizeof(mpz_t));
@@ -63,19 +186,12 @@ memo_t memo_alloc(int N, int M, int bound) {
   return memo;
 }
 
-void memo_free(memo_t memo) {
-  int n, m, k;
-  const int bound = memo.bound;
-  const int M = memo.M;
+void memo_nk_free(memo_nk_t memo) {
+  int n, k;
 
   for (n = 2; n <= memo.N; n++) {
     for (k = 1; k <= n; k++) {
-      const int C = min(n - k, bound);
-      const int max_m = min((C - 1) * C / 2 + C * (n - C), M);
-      for (m = 0; m <= max_m; m++) {
-        mpz_clear(memo.vals[n - 2][k - 1][m]);
-      }
-      free(memo.vals[n - 2][k - 1]);
+      mpz_clear(memo.vals[n - 2][k - 1]);
     }
     free(memo.vals[n - 2]);
   }
@@ -107,15 +223,23 @@ void memo_dump(FILE *fd, const memo_t memo) {
   }
 }
 
-void memo_load(memo_t memo, FILE *fd) {
-  int n, m, k;
+int memo_load(memo_t memo, FILE *fd) {
+  int n, m, k, r;
   mpz_t *z;
 
-  while (1) {
-    if (fscanf(fd, "%d %d %d ", &n, &m, &k) == EOF)
-      break;
+  while ((r = fscanf(fd, "%d %d %d ", &n, &m, &k)) != EOF) {
+    int C;
+    /* The cell must exist in the table. */
+    if (r != 3 || n < 2 || n > memo.N || k < 1 || k > n || m < 0)
+      return -1;
+    C = min(n - k, memo.bound);
+    if (m > min((C - 1) * C / 2 + C * (n - C), memo.M))
+      return -1;
     z = memo_get_ptr(memo, n, m, k);
-    mpz_inp_str(*z, fd, 10);
-    fscanf(fd, "\n");
+    if (mpz_inp_str(*z, fd, 10) == 0 || mpz_sgn(*z) < 0)
+      return -1;
+    if (fscanf(fd, "\n") == EOF)
+      break;
   }
+  return 0;
 }
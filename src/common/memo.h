@@ -0,0 +1,62 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef _RANDDAG_MEMO_H
+#define _RANDDAG_MEMO_H
+
+/* Internals of the memo_t structure shared by the memo_* functions. */
+
+#include <gmp.h>
+
+#include "../../includes/common.h"
+
+/* Allocate the rows (n, k), for k = 1..n, of the n-th layer of a memo_t of
+ * parameters M and bound. All the cells are initialised at zero. */
+mpz_t **memo_layer_alloc(int n, int M, int bound);
+
+/* Free a layer allocated by memo_layer_alloc. */
+void memo_layer_free(mpz_t **layer, int n, int M, int bound);
+
+/* Same as memo_alloc, but leave all the layers unallocated (NULL). A layer
+ * must be allocated with memo_layer_alloc before it is accessed; memo_free
+ * frees the layers that are still allocated. This is how a table is filled
+ * with only a few of its layers in memory at a time (see MEMO_ROLLING). */
+memo_t memo_alloc_empty(int N, int M, int bound);
+
+/* Move the layers of a table of parameters (memo.N, M, bound) allocated by
+ * memo_alloc, together with its small table, to a new table with N >= memo.N
+ * vertices and the same M and bound, and free what remains of the old one.
+ * The layers above memo.N are left empty.
+ * The shapes of the moved layers must not change: M must be at least the
+ * largest number of edges of a graph with memo.N vertices (for instance,
+ * both tables are allocated with M < 0) and bound must be the original one,
+ * not memo.bound (they differ for unbounded tables). As the small table is
+ * kept as is, it must be complete: fill all the layers of memo beforehand. */
+memo_t memo_extend(memo_t memo, int N, int M, int bound);
+
+/* Free the on-demand loading state of a table opened with memo_open_z (see
+ * memo_z.c), including its loaded layers. */
+void memo_lazy_free(memo_t);
+
+/* Choose the engine of a sampling request for the model (see doag_plan),
+ * given the largest n handled by its machine-integer path and whether it has
+ * a rejection sampler for graphs with n vertices (e.g. doag_unif_n). */
+sampler_plan_t sampler_plan(const char *model, int small_N, int rejection,
+                            int n, int m, int k, int bound,
+                            unsigned long count, size_t max_bytes);
+
+#endif
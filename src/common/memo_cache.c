@@ -0,0 +1,283 @@
+#define _POSIX_C_SOURCE 200809L
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Persistent cache of counting tables.
+ *
+ * The tables are stored in a directory as compressed dumps (see memo_z.c),
+ * named after their model and parameters. The parameters are read back from
+ * the headers of the dumps, the names only serve to tell the models apart
+ * and to avoid collisions.
+ * A dump is written to a temporary file which is then renamed, so that the
+ * other processes only ever see complete dumps: two processes extending the
+ * same table at the same time both compute it, and one of the two copies
+ * replaces the other. Files are never modified in place, so the dumps being
+ * read by other processes are left intact when they are replaced. */
+
+#include <stdio.h>
+#include <gmp.h>
+#include <dirent.h>    /* opendir, readdir, closedir */
+#include <malloc.h>    /* malloc, free */
+#include <stdlib.h>    /* getenv */
+#include <string.h>    /* strlen, strcmp, strncmp, strcpy */
+#include <sys/stat.h>  /* mkdir, stat */
+#include <sys/types.h> /* pid_t */
+#include <unistd.h>    /* getpid, unlink */
+
+#include "../../includes/common.h"
+
+#define max(x, y) (((x) < (y)) ? (y) : (x))
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Largest number of edges of a graph with n >= 1 vertices. */
+static int _max_m(int n, int bound) {
+  const int C = min(n - 1, bound);
+  return (C * (C - 1)) / 2 + C * (n - C);
+}
+
+/* The default cache directory, to be freed by the caller, or NULL if there is
+ * none. */
+static char *_default_dir(void) {
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  char *dir;
+
+  if (xdg != NULL && xdg[0] != '\0') {
+    dir = malloc(strlen(xdg) + 9);
+    sprintf(dir, "%s/randdag", xdg);
+  } else if (home != NULL && home[0] != '\0') {
+    dir = malloc(strlen(home) + 16);
+    sprintf(dir, "%s/.cache/randdag", home);
+  } else {
+    dir = NULL;
+  }
+  return dir;
+}
+
+/* Create a directory and its parents if needed. Return 0 if it exists in the
+ * end. */
+static int _mkdirs(const char *dir) {
+  struct stat st;
+  char *path = malloc(strlen(dir) + 1);
+  char *p;
+
+  strcpy(path, dir);
+  for (p = path + 1; *p != '\0'; p++) {
+    if (*p == '/') {
+      *p = '\0';
+      mkdir(path, 0777);
+      *p = '/';
+    }
+  }
+  mkdir(path, 0777);
+  free(path);
+  return (stat(dir, &st) == 0 && S_ISDIR(st.st_mode)) ? 0 : -1;
+}
+
+/* A dump of the cache and its parameters. */
+typedef struct {
+  char *path;
+  int N, M, bound;
+  long size;
+} _entry;
+
+/* Tell whether the layers 2 to n of a dump computed for `bound` can be loaded
+ * in a table for `memo_bound`, see memo_load_range. */
+static int _compatible(int bound, int memo_bound, int n) {
+  return bound == memo_bound || n - 1 <= min(bound, memo_bound);
+}
+
+/* Call f on each valid dump of the given model in dir. The path of the entry
+ * is only valid during the call. Return -1 if dir cannot be read. */
+static int _scan(const char *dir, const char *model,
+                 void (*f)(const _entry *, void *), void *arg) {
+  const size_t len = strlen(model);
+  DIR *d = opendir(dir);
+  struct dirent *e;
+
+  if (d == NULL)
+    return -1;
+
+  while ((e = readdir(d)) != NULL) {
+    char file_model[MEMO_Z_MODEL_LEN + 1];
+    _entry cur;
+    struct stat st;
+    FILE *fd;
+    int ok;
+    const size_t name_len = strlen(e->d_name);
+
+    if (strncmp(e->d_name, model, len) != 0 || e->d_name[len] != '-' ||
+        name_len < 4 || strcmp(e->d_name + name_len - 4, ".rdz") != 0)
+      continue;
+
+    cur.path = malloc(strlen(dir) + name_len + 2);
+    sprintf(cur.path, "%s/%s", dir, e->d_name);
+    fd = fopen(cur.path, "rb");
+    ok = fd != NULL && fstat(fileno(fd), &st) == 0 &&
+         memo_z_header(fd, file_model, &cur.N, &cur.M, &cur.bound) == 0 &&
+         strcmp(file_model, model) == 0 && cur.N >= 2;
+    if (fd != NULL)
+      fclose(fd);
+    if (ok) {
+      cur.size = st.st_size;
+      f(&cur, arg);
+    }
+    free(cur.path);
+  }
+
+  closedir(d);
+  return 0;
+}
+
+/* State of the lookup of the best dump for a table of parameters N, M and
+ * bound: the smallest one that covers the table if any, or the one that covers
+ * the most layers otherwise. */
+typedef struct {
+  int N, M, bound;
+  int found, covers;
+  _entry best;
+} _lookup;
+
+static void _choose(const _entry *cur, void *arg) {
+  _lookup *l = arg;
+  const int useful = min(cur->N, l->N);
+  const int covers = cur->N >= l->N && cur->M >= l->M;
+
+  if (!_compatible(cur->bound, l->bound, useful))
+    return;
+  if (!l->found || (covers && (!l->covers || cur->size < l->best.size)) ||
+      (!covers && !l->covers &&
+       (useful > min(l->best.N, l->N) ||
+        (useful == min(l->best.N, l->N) && cur->size < l->best.size)))) {
+    if (l->found)
+      free(l->best.path);
+    l->best = *cur;
+    l->best.path = malloc(strlen(cur->path) + 1);
+    strcpy(l->best.path, cur->path);
+    l->found = 1;
+    l->covers = covers;
+  }
+}
+
+/* Remove the dumps whose content is part of the table arg, except the file
+ * of the table itself. */
+static void _remove_covered(const _entry *cur, void *arg) {
+  const _entry *table = arg;
+
+  if (strcmp(cur->path, table->path) != 0 && cur->N <= table->N &&
+      cur->M <= table->M && _compatible(cur->bound, table->bound, cur->N))
+    unlink(cur->path);
+}
+
+/* Write memo to the cache atomically and remove the dumps it makes
+ * useless. */
+static int _store(const char *dir, const char *model, memo_t memo) {
+  _entry table;
+  char *tmp = malloc(strlen(dir) + strlen(model) + 96);
+  FILE *fd;
+  int error;
+
+  table.path = malloc(strlen(dir) + strlen(model) + 64);
+  table.N = memo.N;
+  table.M = memo.M;
+  table.bound = memo.bound;
+  sprintf(table.path, "%s/%s-%d-%d-%d.rdz", dir, model, memo.bound, memo.N,
+          memo.M);
+  sprintf(tmp, "%s/.%s-%d-%d-%d.%ld.tmp", dir, model, memo.bound, memo.N,
+          memo.M, (long)getpid());
+
+  fd = fopen(tmp, "wb");
+  error = fd == NULL;
+  if (!error) {
+    error = memo_dump_z(fd, memo, model, NULL) != 0;
+    error |= fclose(fd) != 0;
+    error = error || rename(tmp, table.path) != 0;
+    if (error)
+      unlink(tmp);
+  }
+  if (!error)
+    _scan(dir, model, _remove_covered, &table);
+
+  free(table.path);
+  free(tmp);
+  return error ? -1 : 0;
+}
+
+int memo_cache_get(memo_t *memo, const char *dir, const char *model,
+                   randdag_counter_t count, int N, int M, int bound) {
+  int n, B, M_eff, status;
+  char *default_dir = NULL;
+  _lookup l;
+
+  /* Tiny tables have nothing to cache. */
+  if (N < 2) {
+    *memo = memo_alloc(N, M, bound);
+    return 0;
+  }
+
+  if (dir == NULL)
+    dir = default_dir = _default_dir();
+  if (dir == NULL || _mkdirs(dir) != 0) {
+    /* No cache: compute the table. */
+    *memo = memo_alloc(N, M, bound);
+    for (n = 2; n <= N; n++)
+      memo_fill_layer(*memo, count, n);
+    free(default_dir);
+    return -1;
+  }
+
+  /* The number of edges we need, as memo_alloc would store it. */
+  B = bound < 0 ? N : bound;
+  M_eff = M < 0 ? _max_m(N, B) : min(M, _max_m(N, B));
+
+  l.N = N;
+  l.M = M_eff;
+  l.bound = B;
+  l.found = l.covers = 0;
+  _scan(dir, model, _choose, &l);
+
+  if (l.found) {
+    /* The table must have room for all the cells of the layers we load. */
+    const int n_hi = min(l.best.N, N);
+    FILE *fd = fopen(l.best.path, "rb");
+    *memo = memo_alloc(N, max(M_eff, min(l.best.M, _max_m(n_hi, B))), bound);
+    if (fd == NULL || memo_load_range(*memo, fd, 2, n_hi) != 0) {
+      /* Removed or invalid in the meantime: start over. */
+      memo_free(*memo);
+      *memo = memo_alloc(N, M_eff, bound);
+      l.covers = 0;
+    }
+    if (fd != NULL)
+      fclose(fd);
+    free(l.best.path);
+  } else {
+    *memo = memo_alloc(N, M_eff, bound);
+  }
+
+  if (l.covers) {
+    status = 1;
+  } else {
+    /* Compute the missing layers (or cells, if the dump was computed for
+     * fewer edges) and save the result. */
+    for (n = 2; n <= N; n++)
+      memo_fill_layer(*memo, count, n);
+    status = _store(dir, model, *memo);
+  }
+
+  free(default_dir);
+  return status;
+}
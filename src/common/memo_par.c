@@ -0,0 +1,270 @@
+#define _POSIX_C_SOURCE 200809L
+
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Multi-threaded versions of memo_dump and memo_load (text format).
+ *
+ * The cost of both functions is dominated by the conversions between decimal
+ * strings and GMP integers, which are independent from one cell to the other.
+ * The loader maps the file, splits it into chunks at line boundaries, and each
+ * thread parses its chunk directly into the cells of the table. The dumper
+ * formats each layer of the table with several threads into separate buffers
+ * that are then written in order, so that its output is identical to that of
+ * memo_dump. */
+
+#include <stdio.h>
+/* Keep stdio.h above gmp.h, see cli.c. */
+#include <gmp.h>
+#include <malloc.h>   /* malloc, realloc, free */
+#include <pthread.h>  /* pthread_create, pthread_join */
+#include <string.h>   /* memcpy, memchr, strlen */
+#include <sys/mman.h> /* mmap, munmap */
+#include <sys/stat.h> /* fstat */
+
+#include "../../includes/common.h"
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+static int _max_m(const memo_t memo, int n, int k) {
+  const int C = min(n - k, memo.bound);
+  return min((C - 1) * C / 2 + C * (n - C), memo.M);
+}
+
+/* --- Parallel load ------------------------------------------------------ */
+
+typedef struct {
+  memo_t memo;
+  const char *start, *end;
+  int error;
+} _load_job;
+
+/* Parse a non-negative decimal integer followed by a space. */
+static const char *_parse_int(const char *c, const char *end, int *x) {
+  *x = 0;
+  if (c >= end || *c < '0' || *c > '9')
+    return NULL;
+  while (c < end && *c >= '0' && *c <= '9')
+    *x = 10 * *x + (*c++ - '0');
+  if (c >= end || *c != ' ')
+    return NULL;
+  return c + 1;
+}
+
+static void *_load_worker(void *arg) {
+  _load_job *job = arg;
+  const char *c = job->start;
+  size_t cap = 64;
+  char *digits = malloc(cap);
+
+  while (c < job->end && !job->error) {
+    int n, m, k;
+    size_t len;
+    const char *eol = memchr(c, '\n', job->end - c);
+    if (eol == NULL)
+      eol = job->end;
+
+    /* Skip empty lines, e.g. at the end of the file. */
+    if (eol == c) {
+      c++;
+      continue;
+    }
+
+    if ((c = _parse_int(c, eol, &n)) == NULL ||
+        (c = _parse_int(c, eol, &m)) == NULL ||
+        (c = _parse_int(c, eol, &k)) == NULL || n < 2 || n > job->memo.N ||
+        k < 1 || k > n || m > _max_m(job->memo, n, k)) {
+      job->error = 1;
+      break;
+    }
+
+    /* mpz_set_str needs a null-terminated string. */
+    len = eol - c;
+    if (len + 1 > cap) {
+      cap = len + 1;
+      digits = realloc(digits, cap);
+    }
+    memcpy(digits, c, len);
+    digits[len] = '\0';
+    if (mpz_set_str(*memo_get_ptr(job->memo, n, m, k), digits, 10) != 0)
+      job->error = 1;
+
+    c = eol + 1;
+  }
+
+  free(digits);
+  return NULL;
+}
+
+int memo_load_parallel(memo_t memo, FILE *fd, int nb_threads) {
+  struct stat st;
+  char *map = NULL, *data;
+  size_t len, mapped = 0;
+  long pos = ftell(fd);
+  int i, error = 0;
+  pthread_t *threads;
+  _load_job *jobs;
+
+  if (nb_threads < 1)
+    nb_threads = 1;
+
+  /* Map the file if possible, read it into memory otherwise. */
+  if (pos >= 0 && fstat(fileno(fd), &st) == 0 && S_ISREG(st.st_mode) &&
+      st.st_size > pos) {
+    mapped = st.st_size;
+    map = mmap(NULL, mapped, PROT_READ, MAP_PRIVATE, fileno(fd), 0);
+    if (map == MAP_FAILED)
+      map = NULL;
+  }
+  if (map != NULL) {
+    data = map + pos;
+    len = mapped - pos;
+    fseek(fd, 0, SEEK_END);
+  } else {
+    size_t cap = 1 << 20, r;
+    data = malloc(cap);
+    len = 0;
+    while ((r = fread(data + len, 1, cap - len, fd)) > 0) {
+      len += r;
+      if (len == cap)
+        data = realloc(data, cap *= 2);
+    }
+  }
+
+  threads = malloc(nb_threads * sizeof(pthread_t));
+  jobs = malloc(nb_threads * sizeof(_load_job));
+
+  /* Split at line boundaries. */
+  for (i = 0; i < nb_threads; i++) {
+    const char *end = data + len / nb_threads * (i + 1);
+    if (i == nb_threads - 1) {
+      end = data + len;
+    } else {
+      end = memchr(end, '\n', data + len - end);
+      end = (end == NULL) ? data + len : end + 1;
+    }
+    jobs[i].memo = memo;
+    jobs[i].start = (i == 0) ? data : jobs[i - 1].end;
+    jobs[i].end = end;
+    jobs[i].error = 0;
+    /* Chunks may be empty if some lines are very long. */
+    if (jobs[i].end < jobs[i].start)
+      jobs[i].end = jobs[i].start;
+  }
+  for (i = 0; i < nb_threads; i++)
+    pthread_create(&threads[i], NULL, _load_worker, &jobs[i]);
+  for (i = 0; i < nb_threads; i++) {
+    pthread_join(threads[i], NULL);
+    error |= jobs[i].error;
+  }
+
+  free(threads);
+  free(jobs);
+  if (map != NULL)
+    munmap(map, mapped);
+  else
+    free(data);
+
+  return error ? -1 : 0;
+}
+
+/* --- Parallel dump ------------------------------------------------------ */
+
+typedef struct {
+  memo_t memo;
+  int n, k_lo, k_hi;
+  char *buf;
+  size_t len, cap;
+} _dump_job;
+
+static void *_dump_worker(void *arg) {
+  _dump_job *job = arg;
+  const int n = job->n;
+  int m, k;
+
+  job->len = 0;
+  for (k = job->k_lo; k < job->k_hi; k++) {
+    const int max_m = _max_m(job->memo, n, k);
+    for (m = 0; m <= max_m; m++) {
+      mpz_t *x = memo_get_ptr(job->memo, n, m, k);
+      if (mpz_sgn(*x) > 0) {
+        /* Room for "n m k value\n" and the null byte of sprintf. */
+        const size_t need = 3 * 12 + mpz_sizeinbase(*x, 10) + 2;
+        if (job->len + need > job->cap) {
+          while (job->len + need > job->cap)
+            job->cap = job->cap ? 2 * job->cap : 1 << 16;
+          job->buf = realloc(job->buf, job->cap);
+        }
+        job->len += sprintf(job->buf + job->len, "%d %d %d ", n, m, k);
+        mpz_get_str(job->buf + job->len, 10, *x);
+        job->len += strlen(job->buf + job->len);
+        job->buf[job->len++] = '\n';
+      }
+    }
+  }
+
+  return NULL;
+}
+
+void memo_dump_parallel(FILE *fd, const memo_t memo, int nb_threads) {
+  int n, k, i;
+  pthread_t *threads;
+  _dump_job *jobs;
+
+  if (nb_threads < 1)
+    nb_threads = 1;
+  threads = malloc(nb_threads * sizeof(pthread_t));
+  jobs = calloc(nb_threads, sizeof(_dump_job));
+
+  fprintf(fd, "%d %d %d\n", memo.N, memo.M, memo.bound);
+
+  for (n = 2; n <= memo.N; n++) {
+    /* Split the rows of the layer into blocks of about the same number of
+     * cells. */
+    long total = 0, acc = 0;
+    for (k = 1; k <= n; k++)
+      total += _max_m(memo, n, k) + 1;
+
+    i = 0;
+    jobs[0].k_lo = 1;
+    for (k = 1; k <= n; k++) {
+      acc += _max_m(memo, n, k) + 1;
+      if (i < nb_threads - 1 && acc * nb_threads >= total * (i + 1)) {
+        jobs[i].k_hi = k + 1;
+        jobs[++i].k_lo = k + 1;
+      }
+    }
+    jobs[i].k_hi = n + 1;
+    for (i = i + 1; i < nb_threads; i++)
+      jobs[i].k_lo = jobs[i].k_hi = n + 1;
+
+    for (i = 0; i < nb_threads; i++) {
+      jobs[i].memo = memo;
+      jobs[i].n = n;
+      pthread_create(&threads[i], NULL, _dump_worker, &jobs[i]);
+    }
+    for (i = 0; i < nb_threads; i++) {
+      pthread_join(threads[i], NULL);
+      fwrite(jobs[i].buf, 1, jobs[i].len, fd);
+    }
+  }
+
+  for (i = 0; i < nb_threads; i++)
+    free(jobs[i].buf);
+  free(threads);
+  free(jobs);
+}
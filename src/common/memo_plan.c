@@ -0,0 +1,248 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Memory planning of counting tables, see memo_plan.
+ *
+ * The size of a cell of the layer n for m edges is estimated from an upper
+ * bound on the bit-length of its count, valid for all numbers of sources:
+ * there are at most n! * binom(n(n-1)/2, m) labelled DAGs with n vertices and
+ * m edges (choose a topological order, then the edges), and the out-edges of
+ * a DOAG can moreover be ordered in about ((m/n)!)^n ways. In practice, the
+ * resulting estimate exceeds the size of a filled table by 10% to 40%. */
+
+#include <stdio.h>
+#include <gmp.h>
+#include <math.h>   /* log, ceil */
+#include <string.h> /* strcmp */
+
+#include "../../includes/common.h"
+#include "memo.h"
+
+#define max(x, y) (((x) < (y)) ? (y) : (x))
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Number of points at which the size of the cells of a row is evaluated. */
+#define ROW_POINTS 8
+/* Number of rows at which the size of a large layer is evaluated. */
+#define LAYER_ROWS 32
+
+/* Estimate of log2(x!) (Stirling's formula). */
+static double _log2_fact(double x) {
+  const double pi = 3.14159265358979323846;
+  if (x < 2)
+    return 0;
+  return (x * log(x) - x + 0.5 * log(2 * pi * x) + 1 / (12 * x)) / log(2.);
+}
+
+/* Upper bound on the bit-length of the counts of the layer n for m edges. */
+static double _cell_bits(int ordered, int n, int m) {
+  double bits = _log2_fact(n) + _log2_fact((double)n * (n - 1) / 2) -
+                _log2_fact(m) - _log2_fact((double)n * (n - 1) / 2 - m);
+  if (ordered)
+    bits += n * _log2_fact((double)m / n);
+  return bits;
+}
+
+/* Estimated size in bytes of a GMP integer of the given bit-length: the limbs
+ * and the overhead of their allocation. */
+static double _mpz_bytes(double bits) {
+  return ceil(max(bits, 1) / GMP_NUMB_BITS) * sizeof(mp_limb_t) + 16;
+}
+
+/* Estimated size in bytes of a non-zero cell of the layer n for m edges. */
+static double _cell_bytes(int ordered, int n, int m) {
+  return _mpz_bytes(_cell_bits(ordered, n, m));
+}
+
+/* Estimated size in bytes of the row of the layer n for k sources, and its
+ * number of cells. */
+static double _row_bytes(int ordered, int n, int k, int M, int bound,
+                         double *cells) {
+  int i;
+  const int C = min(bound, n - k);
+  const int max_m = min((C - 1) * C / 2 + C * (n - C), M);
+  /* The cells below n - k edges are allocated but stay at zero. */
+  const int lo = min(n - k, max_m + 1);
+  const int nb = max_m + 1 - lo;
+  const int points = min(nb, ROW_POINTS);
+  double sum = 0, bytes = (max_m + 1) * sizeof(mpz_t);
+
+  *cells = max_m + 1;
+  /* Evenly spaced numbers of edges, including both ends. */
+  for (i = 0; i < points; i++) {
+    const int m =
+        points > 1 ? lo + (int)((double)i * (nb - 1) / (points - 1)) : lo;
+    sum += _cell_bytes(ordered, n, m);
+  }
+  if (points > 0)
+    bytes += sum / points * nb;
+  return bytes;
+}
+
+/* Estimated size in bytes of the layer n, and its number of cells. Large
+ * layers are estimated from LAYER_ROWS evenly spaced rows (trapezoidal
+ * rule), so that planning a table takes time O(N). */
+static double _layer_bytes(int ordered, int n, int M, int bound,
+                           double *cells) {
+  int k, i, prev_k = 1;
+  double c, prev_c = 0, prev = 0, bytes = n * sizeof(mpz_t *);
+
+  if (n <= LAYER_ROWS) {
+    for (k = 1; k <= n; k++) {
+      bytes += _row_bytes(ordered, n, k, M, bound, &c);
+      *cells += c;
+    }
+    return bytes;
+  }
+
+  for (i = 0; i < LAYER_ROWS; i++) {
+    const int k = 1 + (int)((double)i * (n - 1) / (LAYER_ROWS - 1));
+    const double row = _row_bytes(ordered, n, k, M, bound, &c);
+    if (i > 0) {
+      const double width = k - prev_k;
+      bytes += (row + prev) / 2 * width;
+      *cells += (c + prev_c) / 2 * width;
+    } else {
+      /* The trapezoids cover n - 1 rows: count the ends half more. */
+      bytes += row / 2;
+      *cells += c / 2;
+    }
+    if (i == LAYER_ROWS - 1) {
+      bytes += row / 2;
+      *cells += c / 2;
+    }
+    prev = row;
+    prev_c = c;
+    prev_k = k;
+  }
+  return bytes;
+}
+
+memo_plan_t memo_plan(const char *model, int N, int M, int bound,
+                      size_t max_bytes, int all_layers, int on_disk) {
+  int n;
+  double prev = 0;
+  memo_plan_t plan;
+  const int ordered = strcmp(model, "ldag") != 0;
+
+  /* Same conventions as memo_alloc. */
+  if (bound < 0)
+    bound = N;
+  if (M < 0)
+    M = N * (N - 1) / 2;
+
+  plan.cells = 0;
+  plan.dense = N > 1 ? (N - 1) * sizeof(mpz_t **) : 0;
+  plan.rolling = plan.out_of_core = 0;
+  for (n = 2; n <= N; n++) {
+    const double bytes = _layer_bytes(ordered, n, M, bound, &plan.cells);
+    plan.dense += bytes;
+    plan.rolling = max(plan.rolling, prev + bytes);
+    plan.out_of_core = max(plan.out_of_core, bytes);
+    prev = bytes;
+  }
+
+  if (max_bytes == 0 || plan.dense <= max_bytes)
+    plan.strategy = MEMO_DENSE;
+  else if (!all_layers && plan.rolling <= max_bytes)
+    plan.strategy = MEMO_ROLLING;
+  else if (on_disk && plan.out_of_core <= max_bytes)
+    plan.strategy = MEMO_OUT_OF_CORE;
+  else
+    plan.strategy = MEMO_NONE;
+  return plan;
+}
+
+/* --- Sampling engines --------------------------------------------------- */
+
+static const char *const _engines[4] = {"rejection", "compact", "small",
+                                        "recursive"};
+
+const char *sampler_engine_name(int engine) {
+  return (engine >= 0 && engine < 4) ? _engines[engine] : "none";
+}
+
+/* Estimated size in bytes of a compact table (memo_nk_t) for up to N
+ * vertices. Its cells are sums over all the numbers of edges. */
+static double _nk_bytes(int ordered, int N, int bound) {
+  int n, i;
+  double bytes = N > 1 ? (N - 1) * sizeof(mpz_t *) : 0;
+
+  for (n = 2; n <= N; n++) {
+    const int C = min(bound, n - 1);
+    const int max_m = (C - 1) * C / 2 + C * (n - C);
+    double bits = 0;
+    for (i = 0; i < ROW_POINTS; i++) {
+      const int m = (int)((double)i * max_m / (ROW_POINTS - 1));
+      bits = max(bits, _cell_bits(ordered, n, m));
+    }
+    bits += log(max_m + 1.) / log(2.);
+    bytes += n * (sizeof(mpz_t) + _mpz_bytes(bits));
+  }
+  return bytes;
+}
+
+sampler_plan_t sampler_plan(const char *model, int small_N, int rejection,
+                            int n, int m, int k, int bound,
+                            unsigned long count, size_t max_bytes) {
+  sampler_plan_t plan;
+  memo_plan_t table;
+  const int ordered = strcmp(model, "ldag") != 0;
+  const int B = bound < 0 ? n : bound;
+  /* The cost of a cell, or of drawing the out-edges of a vertex, is linear
+   * in the largest out-degree. */
+  const double C = max(min(B, n - 1), 0) + 1;
+
+  if (count < 1)
+    count = 1;
+
+  /* The rejection sampler draws from another class of graphs (see
+   * doag_unif_n): it is used for all the requests of this class, and only
+   * for them, so that the output does not depend on the size. It needs no
+   * table, which is not even estimated. */
+  if (m < 0 && k < 0 && rejection && bound < 0) {
+    plan.engine = RD_ENGINE_REJECTION;
+    plan.needs_memo = 0;
+    plan.bytes = 0;
+    plan.cost = (double)count * n;
+    plan.fits = 1;
+    return plan;
+  }
+
+  /* Otherwise: fill a table once, then sample from it, with machine
+   * integers for tiny graphs. */
+  table = memo_plan(model, n, m, bound, 0, 1, 0);
+  plan.engine = n <= small_N ? RD_ENGINE_SMALL : RD_ENGINE_RECURSIVE;
+  plan.needs_memo = 1;
+  plan.bytes = table.dense;
+  plan.cost = C * (table.cells + (double)count * n);
+
+  if (n > small_N && m < 0 && k < 0) {
+    /* The compact table is rebuilt for each graph. It wins for a few graphs,
+     * or when the full table does not fit. */
+    const double cost = count * C * ((double)n * (n + 1) / 2 + n);
+    if (cost < plan.cost || (max_bytes > 0 && plan.bytes > max_bytes)) {
+      plan.engine = RD_ENGINE_COMPACT;
+      plan.needs_memo = 0;
+      plan.bytes = _nk_bytes(ordered, n, B);
+      plan.cost = cost;
+    }
+  }
+
+  plan.fits = max_bytes == 0 || plan.bytes <= max_bytes;
+  return plan;
+}
@@ -0,0 +1,696 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Compressed memo dumps.
+ *
+ * File layout (all integers are little-endian):
+ * - a 32-byte header: the magic string "RDMZ", the version of the format over
+ *   4 bytes (currently 2), the name of the model over 8 bytes (padded with
+ *   null bytes), the N, M and bound fields of the dumped memo_t over 4 bytes
+ *   each, and the checksum of the 28 previous bytes over 4 bytes;
+ * - for each layer n = 2..N, the cells of the rows (n, k) for k = 1..n, each
+ *   row containing the cells m = 0..max_m in the same shape as in memo.vals.
+ *   The rows of a layer are grouped into chunks of a few MiB, each chunk being
+ *   stored as its uncompressed size and its compressed size over 4 bytes,
+ *   followed by the compressed data (or by the raw data if both sizes are
+ *   equal). A chunk always contains whole rows;
+ * - the index of the layers: for each layer n = 2..N, its offset in the file
+ *   and its size over 8 bytes each, and the checksum of its content over 4
+ *   bytes;
+ * - a 16-byte trailer: the offset of the index over 8 bytes, its checksum over
+ *   4 bytes, and the magic string "RDMZ" again.
+ * Checksums are 32-bit FNV-1a hashes.
+ *
+ * Before compression, each cell is encoded relatively to the previous cell of
+ * its row (the first cell of a row being relative to zero):
+ * - the number of bytes of the odd part of the value (0 if the cell is empty),
+ *   as the difference to that of the previous cell;
+ * - for non-empty cells only, the 2-adic valuation of the value as the
+ *   difference to that of the previous non-empty cell, followed by the bytes
+ *   of its odd part.
+ * Differences are written as zigzag-encoded variable-length integers (7 bits
+ * per byte, least significant group first). The counts have large powers of
+ * two as factors, that are thus stored in a few bytes. The binary encoding
+ * alone saves more than half the size of the text format, the lz stage mostly
+ * removes the runs of empty cells. */
+
+#include <stdio.h>
+/* Keep stdio.h above gmp.h, see cli.c. */
+#include <gmp.h>
+#include <malloc.h> /* malloc, realloc, free */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memcmp, memcpy, memset, strncpy */
+#include <time.h>   /* clock */
+
+#include "../../includes/common.h"
+#include "lz.h"
+#include "memo.h"
+#include "writer.h"
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+#define MEMO_Z_VERSION 2
+#define MEMO_Z_HEADER 32
+#define MEMO_Z_LAYER 20
+#define MEMO_Z_TRAILER 16
+/* Size above which a chunk is closed at the end of the current row. */
+#define MEMO_Z_CHUNK (1 << 22)
+
+/* --- Growable byte buffer ----------------------------------------------- */
+
+typedef struct {
+  unsigned char *p;
+  size_t len, cap;
+} _buffer;
+
+static void _reserve(_buffer *b, size_t nb) {
+  if (b->len + nb > b->cap) {
+    while (b->len + nb > b->cap)
+      b->cap = b->cap ? 2 * b->cap : 4096;
+    b->p = realloc(b->p, b->cap);
+  }
+}
+
+static void _put_varint(_buffer *b, long x) {
+  /* Zigzag: 0, -1, 1, -2, ... are mapped to 0, 1, 2, 3, ... */
+  unsigned long z = (x < 0) ? 2 * (unsigned long)(-(x + 1)) + 1
+                            : 2 * (unsigned long)x;
+  _reserve(b, 10);
+  while (z >= 0x80) {
+    b->p[b->len++] = (unsigned char)(z | 0x80);
+    z >>= 7;
+  }
+  b->p[b->len++] = (unsigned char)z;
+}
+
+static int _get_varint(const unsigned char **i, const unsigned char *i_end,
+                       long *x) {
+  unsigned long z = 0;
+  int shift = 0;
+
+  do {
+    if (*i >= i_end || shift > 63)
+      return -1;
+    z |= (unsigned long)(**i & 0x7f) << shift;
+    shift += 7;
+  } while (*(*i)++ & 0x80);
+
+  *x = (z & 1) ? -(long)(z >> 1) - 1 : (long)(z >> 1);
+  return 0;
+}
+
+/* 32-bit FNV-1a hash, h being the hash of the previous bytes (or
+ * FNV_INIT). */
+#define FNV_INIT 2166136261UL
+
+static unsigned long _fnv(unsigned long h, const unsigned char *p, size_t len) {
+  while (len--) {
+    h ^= *p++;
+    h = (h * 16777619UL) & 0xffffffffUL;
+  }
+  return h;
+}
+
+static void _put_le(unsigned char *p, unsigned long x, int nb) {
+  int i;
+  for (i = 0; i < nb; i++) {
+    p[i] = (unsigned char)(x & 0xff);
+    x = (x >> 4) >> 4;
+  }
+}
+
+static unsigned long _get_le(const unsigned char *p, int nb) {
+  int i;
+  unsigned long x = 0;
+  for (i = nb - 1; i >= 0; i--)
+    x = ((x << 4) << 4) | p[i];
+  return x;
+}
+
+/* --- Shape of the table ------------------------------------------------- */
+
+static int _max_m(int n, int k, int M, int bound) {
+  const int C = min(n - k, bound);
+  return min((C - 1) * C / 2 + C * (n - C), M);
+}
+
+static int _nb_digits(unsigned long x) {
+  int d = 1;
+  while (x >= 10) {
+    x /= 10;
+    d++;
+  }
+  return d;
+}
+
+/* Size of the line of the text format for cell (n, m, k) of value x. */
+static unsigned long _text_size(int n, int m, int k, const mpz_t x) {
+  return _nb_digits(n) + _nb_digits(m) + _nb_digits(k) +
+         mpz_sizeinbase(x, 10) + 4;
+}
+
+/* --- Dump --------------------------------------------------------------- */
+
+/* Compress and write a chunk, return its size in the file. The checksum of the
+ * layer is updated with the bytes written. */
+static size_t _write_chunk(writer_t *w, _buffer *raw, unsigned char *tmp,
+                           unsigned long *checksum) {
+  unsigned char sizes[8];
+  const unsigned char *data = tmp;
+  size_t len = lz_compress(raw->p, raw->len, tmp);
+
+  if (len == 0) {
+    len = raw->len;
+    data = raw->p;
+  }
+  _put_le(sizes, raw->len, 4);
+  _put_le(sizes + 4, len, 4);
+  writer_bytes(w, (const char *)sizes, 8);
+  writer_bytes(w, (const char *)data, len);
+  *checksum = _fnv(_fnv(*checksum, sizes, 8), data, len);
+
+  raw->len = 0;
+  return 8 + len;
+}
+
+int memo_dump_z(FILE *fd, const memo_t memo, const char *model,
+                memo_z_stats *stats) {
+  int n, m, k;
+  long prev_nb, prev_v2;
+  unsigned long text_size, size;
+  unsigned char header[MEMO_Z_HEADER], *index, trailer[MEMO_Z_TRAILER];
+  const size_t index_len = (memo.N > 1 ? memo.N - 1 : 0) * MEMO_Z_LAYER;
+  mpz_t odd;
+  _buffer raw = {NULL, 0, 0};
+  unsigned char *tmp = NULL;
+  size_t tmp_cap = 0;
+  writer_t w;
+  const clock_t start = clock();
+
+  mpz_init(odd);
+  writer_init(&w, fd);
+
+  memset(header, 0, MEMO_Z_HEADER);
+  memcpy(header, "RDMZ", 4);
+  _put_le(header + 4, MEMO_Z_VERSION, 4);
+  strncpy((char *)header + 8, model, MEMO_Z_MODEL_LEN);
+  _put_le(header + 16, memo.N, 4);
+  _put_le(header + 20, memo.M, 4);
+  _put_le(header + 24, memo.bound, 4);
+  _put_le(header + 28, _fnv(FNV_INIT, header, 28), 4);
+  writer_bytes(&w, (const char *)header, MEMO_Z_HEADER);
+  size = MEMO_Z_HEADER;
+  text_size = _nb_digits(memo.N) + _nb_digits(memo.M) +
+              _nb_digits(memo.bound) + 3;
+  index = malloc(index_len + 1);
+
+  for (n = 2; n <= memo.N; n++) {
+    unsigned char *entry = index + (n - 2) * MEMO_Z_LAYER;
+    unsigned long checksum = FNV_INIT;
+    const unsigned long offset = size;
+
+    for (k = 1; k <= n; k++) {
+      const int max_m = _max_m(n, k, memo.M, memo.bound);
+
+      prev_nb = prev_v2 = 0;
+      for (m = 0; m <= max_m; m++) {
+        const mpz_t *x = (const mpz_t *)memo_get_ptr(memo, n, m, k);
+        long nb = 0, v2 = 0;
+
+        if (mpz_sgn(*x) > 0) {
+          v2 = mpz_scan1(*x, 0);
+          mpz_tdiv_q_2exp(odd, *x, v2);
+          nb = (mpz_sizeinbase(odd, 2) + 7) / 8;
+          text_size += _text_size(n, m, k, *x);
+        }
+
+        _put_varint(&raw, nb - prev_nb);
+        prev_nb = nb;
+        if (nb > 0) {
+          size_t count;
+          _put_varint(&raw, v2 - prev_v2);
+          prev_v2 = v2;
+          _reserve(&raw, nb);
+          mpz_export(raw.p + raw.len, &count, -1, 1, 0, 0, odd);
+          raw.len += count;
+        }
+      }
+
+      /* Close the chunk at the end of a large enough row or of the layer. */
+      if (raw.len >= MEMO_Z_CHUNK || k == n) {
+        if (raw.len > tmp_cap) {
+          tmp_cap = raw.len;
+          tmp = realloc(tmp, tmp_cap);
+        }
+        size += _write_chunk(&w, &raw, tmp, &checksum);
+      }
+    }
+
+    _put_le(entry, offset, 8);
+    _put_le(entry + 8, size - offset, 8);
+    _put_le(entry + 16, checksum, 4);
+  }
+
+  /* Index and trailer. */
+  writer_bytes(&w, (const char *)index, index_len);
+  _put_le(trailer, size, 8);
+  _put_le(trailer + 8, _fnv(FNV_INIT, index, index_len), 4);
+  memcpy(trailer + 12, "RDMZ", 4);
+  writer_bytes(&w, (const char *)trailer, MEMO_Z_TRAILER);
+  size += index_len + MEMO_Z_TRAILER;
+
+  mpz_clear(odd);
+  free(raw.p);
+  free(tmp);
+  free(index);
+
+  if (writer_close(&w) != 0)
+    return -1;
+  if (stats != NULL) {
+    stats->text_size = text_size;
+    stats->size = size;
+    stats->seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  }
+  return 0;
+}
+
+/* --- Load --------------------------------------------------------------- */
+
+int memo_z_header(FILE *fd, char *model, int *N, int *M, int *bound) {
+  unsigned char header[MEMO_Z_HEADER];
+
+  if (fread(header, 1, MEMO_Z_HEADER, fd) != MEMO_Z_HEADER ||
+      memcmp(header, "RDMZ", 4) != 0 ||
+      _get_le(header + 4, 4) != MEMO_Z_VERSION ||
+      _get_le(header + 28, 4) != _fnv(FNV_INIT, header, 28))
+    return -1;
+
+  if (model != NULL) {
+    memcpy(model, header + 8, MEMO_Z_MODEL_LEN);
+    model[MEMO_Z_MODEL_LEN] = '\0';
+  }
+  *N = (int)_get_le(header + 16, 4);
+  *M = (int)_get_le(header + 20, 4);
+  *bound = (int)_get_le(header + 24, 4);
+  return 0;
+}
+
+/* Decoding state: position of the next cell in the dump. */
+typedef struct {
+  int n, k, m, max_m;
+  long prev_nb, prev_v2;
+} _cursor;
+
+/* Decode the cells of a chunk into the memo. */
+static int _load_chunk(memo_t memo, int M, int bound, _cursor *c,
+                       const unsigned char *i, const unsigned char *i_end,
+                       unsigned long *text_size) {
+  while (i < i_end) {
+    long d_nb, d_v2, nb;
+
+    /* Move to the next row if needed. */
+    if (c->m > c->max_m) {
+      if (c->k == c->n)
+        return -1;
+      c->k++;
+      c->m = 0;
+      c->max_m = _max_m(c->n, c->k, M, bound);
+      c->prev_nb = c->prev_v2 = 0;
+    }
+
+    if (_get_varint(&i, i_end, &d_nb))
+      return -1;
+    nb = c->prev_nb + d_nb;
+    c->prev_nb = nb;
+    if (nb < 0)
+      return -1;
+
+    if (nb > 0) {
+      mpz_t *x;
+      if (_get_varint(&i, i_end, &d_v2) || i_end - i < nb)
+        return -1;
+      c->prev_v2 += d_v2;
+      if (c->prev_v2 < 0)
+        return -1;
+      /* The cells with more edges than the destination table can hold are
+       * skipped. */
+      if (c->m <= _max_m(c->n, c->k, memo.M, memo.bound)) {
+        x = memo_get_ptr(memo, c->n, c->m, c->k);
+        mpz_import(*x, nb, -1, 1, 0, 0, i);
+        mpz_mul_2exp(*x, *x, c->prev_v2);
+        *text_size += _text_size(c->n, c->m, c->k, *x);
+      }
+      i += nb;
+    }
+    c->m++;
+  }
+
+  /* Chunks end at row boundaries. */
+  return (c->m > c->max_m) ? 0 : -1;
+}
+
+/* Decode a whole layer, given as the content of its chunks. */
+static int _load_layer(memo_t memo, int n, int M, int bound,
+                       const unsigned char *i, const unsigned char *i_end,
+                       unsigned long *text_size) {
+  unsigned char *raw = NULL;
+  size_t raw_cap = 0;
+  int error = 0;
+  _cursor c;
+
+  c.n = n;
+  c.k = 1;
+  c.m = 0;
+  c.max_m = _max_m(n, 1, M, bound);
+  c.prev_nb = c.prev_v2 = 0;
+
+  while (!error && (c.k < c.n || c.m <= c.max_m)) {
+    unsigned long raw_len, len;
+    if (i_end - i < 8) {
+      error = 1;
+      break;
+    }
+    raw_len = _get_le(i, 4);
+    len = _get_le(i + 4, 4);
+    i += 8;
+    if (len > raw_len || len > (unsigned long)(i_end - i)) {
+      error = 1;
+      break;
+    }
+
+    if (len == raw_len) {
+      error = _load_chunk(memo, M, bound, &c, i, i + len, text_size);
+    } else {
+      if (raw_len > raw_cap)
+        raw = realloc(raw, raw_cap = raw_len);
+      error = lz_decompress(i, len, raw, raw_len) ||
+              _load_chunk(memo, M, bound, &c, raw, raw + raw_len, text_size);
+    }
+    i += len;
+  }
+
+  free(raw);
+  return (error || i != i_end) ? -1 : 0;
+}
+
+/* Read and check the index of a dump with N layers, and the offset of the index
+ * in the file. */
+static unsigned char *_read_index(FILE *fd, int N,
+                                  unsigned long *index_offset) {
+  unsigned char trailer[MEMO_Z_TRAILER];
+  const size_t index_len = (N > 1 ? N - 1 : 0) * MEMO_Z_LAYER;
+  unsigned char *index = malloc(index_len + 1);
+
+  if (fseek(fd, -MEMO_Z_TRAILER, SEEK_END) != 0 ||
+      fread(trailer, 1, MEMO_Z_TRAILER, fd) != MEMO_Z_TRAILER ||
+      memcmp(trailer + 12, "RDMZ", 4) != 0 ||
+      fseek(fd, (long)(*index_offset = _get_le(trailer, 8)), SEEK_SET) != 0 ||
+      fread(index, 1, index_len, fd) != index_len ||
+      _fnv(FNV_INIT, index, index_len) != _get_le(trailer + 8, 4)) {
+    free(index);
+    return NULL;
+  }
+  return index;
+}
+
+/* Read, check and decode the n-th layer of a dump, using the buffer *buf of
+ * *cap bytes. Return the size of the layer in the file, or 0 on error. */
+static unsigned long _read_layer(memo_t memo, FILE *fd, int n, int M,
+                                 int bound, const unsigned char *index,
+                                 unsigned long index_offset,
+                                 unsigned char **buf, unsigned long *cap,
+                                 unsigned long *text_size) {
+  const unsigned char *entry = index + (n - 2) * MEMO_Z_LAYER;
+  const unsigned long offset = _get_le(entry, 8);
+  const unsigned long len = _get_le(entry + 8, 8);
+
+  if (offset + len > index_offset)
+    return 0;
+  if (len > *cap)
+    *buf = realloc(*buf, *cap = len);
+  if (fseek(fd, (long)offset, SEEK_SET) != 0 ||
+      fread(*buf, 1, len, fd) != len ||
+      _fnv(FNV_INIT, *buf, len) != _get_le(entry + 16, 4) ||
+      _load_layer(memo, n, M, bound, *buf, *buf + len, text_size))
+    return 0;
+  return len;
+}
+
+/* Load the layers n_lo..n_hi of a dump into memo. */
+static int _load_range(memo_t memo, FILE *fd, int n_lo, int n_hi,
+                       memo_z_stats *stats) {
+  int N, M, bound, n, error = 0;
+  unsigned char *index, *layer = NULL;
+  unsigned long index_offset, size, text_size, layer_cap = 0;
+  const clock_t start = clock();
+
+  if (fseek(fd, 0, SEEK_SET) != 0 || memo_z_header(fd, NULL, &N, &M, &bound))
+    return -1;
+
+  if (n_lo < 2)
+    n_lo = 2;
+  if (n_hi > N)
+    n_hi = N;
+  /* The counts depend on the bound, except for the graphs whose out-degree
+   * cannot exceed either of the two bounds. */
+  if (n_hi > memo.N ||
+      (bound != memo.bound && n_hi - 1 > min(bound, memo.bound)))
+    return -1;
+
+  if ((index = _read_index(fd, N, &index_offset)) == NULL)
+    return -1;
+
+  size = MEMO_Z_HEADER + (N - 1) * MEMO_Z_LAYER + MEMO_Z_TRAILER;
+  text_size = _nb_digits(N) + _nb_digits(M) + _nb_digits(bound) + 3;
+
+  /* Seek straight to the layers we need. */
+  for (n = n_lo; n <= n_hi && !error; n++) {
+    const unsigned long len =
+        _read_layer(memo, fd, n, M, bound, index, index_offset, &layer,
+                    &layer_cap, &text_size);
+    error = (len == 0);
+    size += len;
+  }
+
+  free(index);
+  free(layer);
+
+  if (stats != NULL) {
+    stats->text_size = text_size;
+    stats->size = size;
+    stats->seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  }
+  return error ? -1 : 0;
+}
+
+int memo_load_z(memo_t memo, FILE *fd, memo_z_stats *stats) {
+  int N, M, bound;
+
+  if (fseek(fd, 0, SEEK_SET) != 0 || memo_z_header(fd, NULL, &N, &M, &bound))
+    return -1;
+  return _load_range(memo, fd, 2, N, stats);
+}
+
+int memo_load_range(memo_t memo, FILE *fd, int n_lo, int n_hi) {
+  return _load_range(memo, fd, n_lo, n_hi, NULL);
+}
+
+/* --- On-demand loading -------------------------------------------------- */
+
+/* State of a table opened with memo_open_z. Its layers are NULL in memo.vals
+ * until they are accessed, at which point memo_get_ptr calls
+ * memo_get_layer.
+ *
+ * When the loaded layers exceed the memory cap, the least recently used one
+ * is dropped. Hits are not seen by memo_get_layer, so a layer is dated when
+ * it is loaded and when it is accessed again after being dropped.
+ * The counting functions keep a pointer to the cell they are computing while
+ * they access the layers below it (see memo_open_z). This only happens in
+ * the layers that could not be read back: when above the layer being
+ * accessed, those are only retired, i.e. removed from memo.vals, and freed at
+ * the next access to a layer above them or by memo_lazy_release. A retired
+ * layer accessed again is put back as is. */
+typedef struct {
+  FILE *fd;
+  unsigned char *index;
+  unsigned long index_offset;
+  /* The number of edges of the layers of the dump. */
+  int file_M;
+  /* Memory cap (0 if none) and memory used by the loaded layers. */
+  size_t max_bytes, bytes;
+  /* For each layer, the memory it uses (0 if it is not loaded), the date at
+   * which it was last used, whether its cells are computed after loading
+   * (its size then grows) and the layer itself if it is retired. */
+  size_t *sizes;
+  unsigned long *dates, clock;
+  char *computed;
+  mpz_t ***retired;
+  /* Buffer for reading the layers. */
+  unsigned char *buf;
+  unsigned long buf_cap;
+} _lazy;
+
+/* Approximate memory used by the layer n of memo. */
+static size_t _layer_bytes(memo_t memo, mpz_t **layer, int n) {
+  int m, k;
+  size_t bytes = n * sizeof(mpz_t *);
+
+  for (k = 1; k <= n; k++) {
+    const int max_m = _max_m(n, k, memo.M, memo.bound);
+    bytes += (max_m + 1) * sizeof(mpz_t);
+    for (m = 0; m <= max_m; m++)
+      bytes += mpz_size(layer[k - 1][m]) * sizeof(mp_limb_t);
+  }
+  return bytes;
+}
+
+int memo_open_z(memo_t *memo, FILE *fd, int M, size_t max_bytes) {
+  int N, file_M, bound;
+  unsigned long index_offset;
+  unsigned char *index;
+  _lazy *lazy;
+
+  if (fseek(fd, 0, SEEK_SET) != 0 ||
+      memo_z_header(fd, NULL, &N, &file_M, &bound) || N < 2 ||
+      (index = _read_index(fd, N, &index_offset)) == NULL)
+    return -1;
+
+  lazy = malloc(sizeof(_lazy));
+  lazy->fd = fd;
+  lazy->index = index;
+  lazy->index_offset = index_offset;
+  lazy->file_M = file_M;
+  lazy->max_bytes = max_bytes;
+  lazy->bytes = 0;
+  lazy->sizes = calloc(N - 1, sizeof(size_t));
+  lazy->dates = calloc(N - 1, sizeof(unsigned long));
+  lazy->clock = 0;
+  lazy->computed = calloc(N - 1, 1);
+  lazy->retired = calloc(N - 1, sizeof(mpz_t **));
+  lazy->buf = NULL;
+  lazy->buf_cap = 0;
+
+  /* An empty table of the right dimensions, whose layers are all missing. */
+  *memo = memo_alloc(0, (M < 0 || M > file_M) ? file_M : M, bound);
+  free(memo->vals);
+  memo->vals = calloc(N - 1, sizeof(mpz_t **));
+  memo->N = N;
+  memo->lazy = lazy;
+  return 0;
+}
+
+/* Free the retired layers of indices lo to hi. */
+static void _free_retired(memo_t memo, int lo, int hi) {
+  _lazy *lazy = memo.lazy;
+  int j;
+
+  for (j = lo; j <= hi; j++) {
+    if (lazy->retired[j - 2] != NULL) {
+      memo_layer_free(lazy->retired[j - 2], j, memo.M, memo.bound);
+      lazy->retired[j - 2] = NULL;
+    }
+  }
+}
+
+mpz_t **memo_get_layer(memo_t memo, int n) {
+  _lazy *lazy = memo.lazy;
+  unsigned long text_size = 0;
+  int j;
+
+  if (lazy == NULL || n < 2 || n > memo.N) {
+    fprintf(stderr, "memo_get_layer: the layer %d is not in the table\n", n);
+    abort();
+  }
+
+  /* No pointer into the layers below n is held any more. */
+  _free_retired(memo, 2, n - 1);
+
+  if (lazy->retired[n - 2] != NULL) {
+    memo.vals[n - 2] = lazy->retired[n - 2];
+    lazy->retired[n - 2] = NULL;
+  } else {
+    memo.vals[n - 2] = memo_layer_alloc(n, memo.M, memo.bound);
+    lazy->computed[n - 2] = 0;
+    if (_read_layer(memo, lazy->fd, n, lazy->file_M, memo.bound,
+                    lazy->index, lazy->index_offset, &lazy->buf,
+                    &lazy->buf_cap, &text_size) == 0) {
+      /* Start over from an empty layer, the counting functions will fill
+       * it. */
+      memo_layer_free(memo.vals[n - 2], n, memo.M, memo.bound);
+      memo.vals[n - 2] = memo_layer_alloc(n, memo.M, memo.bound);
+      lazy->computed[n - 2] = 1;
+    }
+  }
+  lazy->sizes[n - 2] = _layer_bytes(memo, memo.vals[n - 2], n);
+  lazy->dates[n - 2] = ++lazy->clock;
+  lazy->bytes += lazy->sizes[n - 2];
+
+  if (lazy->max_bytes == 0)
+    return memo.vals[n - 2];
+
+  /* The layers being computed have grown since they were measured. */
+  for (j = 2; j <= memo.N; j++) {
+    if (j != n && lazy->computed[j - 2] && memo.vals[j - 2] != NULL) {
+      lazy->bytes -= lazy->sizes[j - 2];
+      lazy->sizes[j - 2] = _layer_bytes(memo, memo.vals[j - 2], j);
+      lazy->bytes += lazy->sizes[j - 2];
+    }
+  }
+
+  /* Drop the least recently used layers until we fit in the cap. */
+  while (lazy->bytes > lazy->max_bytes) {
+    int oldest = 0;
+    for (j = 2; j <= memo.N; j++) {
+      if (j != n && memo.vals[j - 2] != NULL &&
+          (oldest == 0 || lazy->dates[j - 2] < lazy->dates[oldest - 2]))
+        oldest = j;
+    }
+    if (oldest == 0)
+      break;
+    if (oldest < n || !lazy->computed[oldest - 2])
+      memo_layer_free(memo.vals[oldest - 2], oldest, memo.M, memo.bound);
+    else
+      lazy->retired[oldest - 2] = memo.vals[oldest - 2];
+    memo.vals[oldest - 2] = NULL;
+    lazy->bytes -= lazy->sizes[oldest - 2];
+    lazy->sizes[oldest - 2] = 0;
+  }
+
+  return memo.vals[n - 2];
+}
+
+void memo_lazy_release(memo_t memo) {
+  _free_retired(memo, 2, memo.N);
+}
+
+void memo_lazy_free(memo_t memo) {
+  _lazy *lazy = memo.lazy;
+  int n;
+
+  for (n = 2; n <= memo.N; n++) {
+    if (memo.vals[n - 2] != NULL)
+      memo_layer_free(memo.vals[n - 2], n, memo.M, memo.bound);
+  }
+  _free_retired(memo, 2, memo.N);
+  free(lazy->index);
+  free(lazy->sizes);
+  free(lazy->dates);
+  free(lazy->computed);
+  free(lazy->retired);
+  free(lazy->buf);
+  free(lazy);
+}
@@ -0,0 +1,167 @@
+#define _POSIX_C_SOURCE 200809L
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Progress reports and timings of the command line tools, see progress.h.
+ * The resident memory is read from /proc (Linux only). */
+
+#include <stdio.h>
+#include <gmp.h>
+#include <sys/resource.h> /* getrusage */
+#include <time.h>         /* clock_gettime */
+#include <unistd.h>       /* sysconf */
+
+#include "progress.h"
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+static const char *const _phases[NB_PHASES] = {"alloc",  "load",  "count",
+                                               "sample", "write", "dump"};
+
+double progress_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+unsigned long progress_rss(void) {
+  unsigned long size, resident = 0;
+  FILE *fd = fopen("/proc/self/statm", "r");
+
+  if (fd == NULL)
+    return 0;
+  if (fscanf(fd, "%lu %lu", &size, &resident) != 2)
+    resident = 0;
+  fclose(fd);
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+/* Print a duration as hours, minutes and seconds. */
+static void _duration(FILE *fd, double seconds) {
+  const unsigned long s = seconds < 0 ? 0 : (unsigned long)(seconds + 0.5);
+  if (s >= 3600)
+    fprintf(fd, "%luh%02lum%02lus", s / 3600, (s / 60) % 60, s % 60);
+  else if (s >= 60)
+    fprintf(fd, "%lum%02lus", s / 60, s % 60);
+  else
+    fprintf(fd, "%lus", s);
+}
+
+/* --- Timings ------------------------------------------------------------ */
+
+void timings_init(timings_t *t) {
+  int p;
+  for (p = 0; p < NB_PHASES; p++)
+    t->seconds[p] = 0;
+  t->start = t->phase_start = progress_now();
+  t->engine = NULL;
+}
+
+void timings_end(timings_t *t, phase_t phase) {
+  const double now = progress_now();
+  t->seconds[phase] += now - t->phase_start;
+  t->phase_start = now;
+}
+
+void timings_print(FILE *fd, const timings_t *t, int json) {
+  int p;
+  struct rusage usage;
+  const double total = progress_now() - t->start;
+  /* ru_maxrss is in kilobytes. */
+  const unsigned long peak =
+      getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss * 1024ul : 0;
+
+  if (json) {
+    fprintf(fd, "{");
+    for (p = 0; p < NB_PHASES; p++)
+      fprintf(fd, "\"%s\": %.6f, ", _phases[p], t->seconds[p]);
+    if (t->engine != NULL)
+      fprintf(fd, "\"engine\": \"%s\", ", t->engine);
+    fprintf(fd, "\"total\": %.6f, \"peak_rss\": %lu}\n", total, peak);
+  } else {
+    fprintf(fd, "Timings:\n");
+    for (p = 0; p < NB_PHASES; p++)
+      fprintf(fd, "  %-8s %10.3fs\n", _phases[p], t->seconds[p]);
+    fprintf(fd, "  %-8s %10.3fs\n", "total", total);
+    fprintf(fd, "Peak resident memory: %.1f MiB\n", peak / 1048576.);
+    if (t->engine != NULL)
+      fprintf(fd, "Sampling engine: %s\n", t->engine);
+  }
+}
+
+/* --- Progress reports --------------------------------------------------- */
+
+/* Number of cells of the n-th layer of memo. */
+static unsigned long _layer_cells(memo_t memo, int n) {
+  int k;
+  unsigned long cells = 0;
+  for (k = 1; k <= n; k++) {
+    const int C = min(memo.bound, n - k);
+    cells += min((C - 1) * C / 2 + C * (n - C), memo.M) + 1;
+  }
+  return cells;
+}
+
+/* Estimated cost of the n-th layer of memo. Computing a cell of the n-th
+ * layer sums O(n^2) products of integers of O(n^2) bits in the worst case,
+ * but measurements show that its cost grows roughly like n^3 in practice. */
+static double _layer_work(memo_t memo, int n) {
+  return (double)_layer_cells(memo, n) * n * n * n;
+}
+
+void progress_fill(memo_t memo, randdag_counter_t count, int first) {
+  int n;
+  double work = 0, total_work = 0;
+  unsigned long cells = 0;
+  const double start = progress_now();
+  double last = start;
+
+  for (n = first; n <= memo.N; n++)
+    total_work += _layer_work(memo, n);
+
+  for (n = first; n <= memo.N; n++) {
+    double now;
+
+    memo_fill_layer(memo, count, n);
+    cells += _layer_cells(memo, n);
+    work += _layer_work(memo, n);
+
+    /* The rate is measured since the last report. */
+    now = progress_now();
+    if (now - last < 1 && n < memo.N)
+      continue;
+    fprintf(stderr, "Layer %d/%d, %.0f cells/s, ETA ", n, memo.N,
+            cells / (now > last ? now - last : 1e-9));
+    cells = 0;
+    last = now;
+    _duration(stderr, (now - start) * (total_work - work) / work);
+    fprintf(stderr, ", RSS %.1f MiB\n", progress_rss() / 1048576.);
+  }
+}
+
+void progress_samples(unsigned long done, unsigned long total, double start,
+                      double *last) {
+  const double now = progress_now();
+
+  if (now - *last < 1 && done < total)
+    return;
+  *last = now;
+  fprintf(stderr, "Sampled %lu/%lu graphs, %.1f graphs/s, ETA ", done, total,
+          done / (now > start ? now - start : 1e-9));
+  _duration(stderr, (now - start) * (total - done) / done);
+  fprintf(stderr, ", RSS %.1f MiB\n", progress_rss() / 1048576.);
+}
@@ -0,0 +1,77 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef _RANDDAG_PROGRESS_H
+#define _RANDDAG_PROGRESS_H
+
+/* Progress reports and timings of the command line tools.
+ *
+ * A run is split into phases, whose wall-clock times are accumulated in a
+ * timings_t and summarised at exit. The progress reports are printed on the
+ * standard error output at most once per second. */
+
+#include <stdio.h>
+
+#include "../../includes/common.h" /* memo_t, randdag_counter_t */
+
+typedef enum {
+  PHASE_ALLOC,
+  PHASE_LOAD,
+  PHASE_COUNT,
+  PHASE_SAMPLE,
+  PHASE_WRITE,
+  PHASE_DUMP,
+  NB_PHASES
+} phase_t;
+
+typedef struct {
+  double seconds[NB_PHASES];
+  /* Start of the run and of the current phase. */
+  double start, phase_start;
+  /* The name of the sampling engine (see sampler_engine_name), or NULL. */
+  const char *engine;
+} timings_t;
+
+/* Wall-clock time in seconds, from an arbitrary origin. */
+double progress_now(void);
+
+/* Resident memory of the process, in bytes (0 if unknown). */
+unsigned long progress_rss(void);
+
+/* Start the timer of the run. */
+void timings_init(timings_t *);
+
+/* Account the time elapsed since the last call (or since timings_init) to
+ * the given phase. */
+void timings_end(timings_t *, phase_t);
+
+/* Print the time spent in each phase, the total time, the peak resident
+ * memory and the sampling engine, as text or as a single line of JSON. */
+void timings_print(FILE *, const timings_t *, int json);
+
+/* Fill the layers first to memo.N of the table in order, reporting the
+ * current layer, the number of cells filled per second, an estimate of the
+ * remaining time and the resident memory. */
+void progress_fill(memo_t, randdag_counter_t, int first);
+
+/* Report that done graphs out of total have been sampled since start. The
+ * report is only printed if the last one is more than a second old, or if
+ * done == total. */
+void progress_samples(unsigned long done, unsigned long total, double start,
+                      double *last);
+
+#endif
@@ -0,0 +1,251 @@
+#define _POSIX_C_SOURCE 200809L
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Zero-copy reader for the binary graph formats.
+ *
+ * The files are mapped in memory and the graphs are accessed in place through
+ * randdag_csr_t views: nothing is decoded before it is used. A reader keeps
+ * the location (file, offset and size) of each of its graphs, obtained by
+ * scanning the headers of a single file or from the index of a set of
+ * shards. */
+
+#include <fcntl.h>    /* open */
+#include <malloc.h>   /* malloc, realloc, calloc, free */
+#include <stdio.h>    /* fopen, fscanf, sprintf */
+#include <string.h>   /* memcmp, strcpy, strlen */
+#include <sys/mman.h> /* mmap, munmap */
+#include <sys/stat.h> /* fstat */
+#include <unistd.h>   /* close */
+
+#include "../../includes/common.h"
+
+/* Size of the header of the binary formats, see randdag_write. */
+#define HEADER 24
+
+typedef struct {
+  const unsigned char *map;
+  size_t size;
+  /* Non-zero if mapping the file failed. */
+  int error;
+} _file;
+
+struct randdag_reader {
+  /* The mapped files (one for a single file, one per shard for a corpus, in
+   * which case they are mapped on demand) and the prefix of the shards. */
+  _file *files;
+  unsigned long nb_files;
+  char *prefix;
+  /* Location of each graph. */
+  unsigned long len, *file, *offset, *size;
+};
+
+/* Map a whole file in memory. */
+static void _map(_file *f, const char *filename) {
+  struct stat st;
+  int fd = open(filename, O_RDONLY);
+
+  f->map = NULL;
+  f->size = 0;
+  f->error = 1;
+  if (fd < 0)
+    return;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    f->size = st.st_size;
+    /* Empty files cannot be mapped but contain no graph anyway. */
+    if (f->size == 0) {
+      f->error = 0;
+    } else {
+      void *map = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+        f->map = map;
+        f->error = 0;
+      }
+    }
+  }
+  close(fd);
+}
+
+/* Size of the graph at p, whose header must fit in the len available bytes, or
+ * 0 if it is not valid. */
+static unsigned long _graph_size(const unsigned char *p, size_t len,
+                                 randdag_csr_t *g) {
+  unsigned long size;
+
+  if (len < HEADER || RD_LE32(p + 4) != 1)
+    return 0;
+  if (memcmp(p, "RDCS", 4) == 0)
+    g->format = RD_FMT_CSR;
+  else if (memcmp(p, "RDEL", 4) == 0)
+    g->format = RD_FMT_BIN_EDGES;
+  else
+    return 0;
+
+  g->N = RD_LE64(p + 8);
+  g->M = RD_LE64(p + 16);
+  /* Reject sizes that would not fit in the file before overflowing. */
+  if (g->N >= len || g->M >= len)
+    return 0;
+
+  if (g->format == RD_FMT_CSR) {
+    size = HEADER + 8 * (g->N + 1) + 4 * g->M;
+    g->offsets = p + HEADER;
+    g->sources = NULL;
+    g->targets = p + HEADER + 8 * (g->N + 1);
+    g->stride = 4;
+  } else {
+    size = HEADER + 8 * g->M;
+    g->offsets = NULL;
+    g->sources = p + HEADER;
+    g->targets = p + HEADER + 4;
+    g->stride = 8;
+  }
+  return size <= len ? size : 0;
+}
+
+static randdag_reader_t *_new_reader(unsigned long nb_files) {
+  randdag_reader_t *r = malloc(sizeof(randdag_reader_t));
+  r->files = calloc(nb_files, sizeof(_file));
+  r->nb_files = nb_files;
+  r->prefix = NULL;
+  r->len = 0;
+  r->file = r->offset = r->size = NULL;
+  return r;
+}
+
+/* Append the location of a graph. */
+static void _push(randdag_reader_t *r, unsigned long file,
+                  unsigned long offset, unsigned long size) {
+  /* Grow the arrays when len reaches a power of two. */
+  if ((r->len & (r->len - 1)) == 0) {
+    const unsigned long cap = r->len ? 2 * r->len : 1;
+    r->file = realloc(r->file, cap * sizeof(unsigned long));
+    r->offset = realloc(r->offset, cap * sizeof(unsigned long));
+    r->size = realloc(r->size, cap * sizeof(unsigned long));
+  }
+  r->file[r->len] = file;
+  r->offset[r->len] = offset;
+  r->size[r->len] = size;
+  r->len++;
+}
+
+randdag_reader_t *randdag_reader_open(const char *filename) {
+  size_t pos = 0;
+  randdag_reader_t *r = _new_reader(1);
+
+  _map(&r->files[0], filename);
+  if (r->files[0].error) {
+    randdag_reader_close(r);
+    return NULL;
+  }
+
+  /* Locate the graphs. */
+  while (pos < r->files[0].size) {
+    randdag_csr_t g;
+    const unsigned long size =
+        _graph_size(r->files[0].map + pos, r->files[0].size - pos, &g);
+    if (size == 0) {
+      randdag_reader_close(r);
+      return NULL;
+    }
+    _push(r, 0, pos, size);
+    pos += size;
+  }
+
+  return r;
+}
+
+randdag_reader_t *randdag_corpus_open(const char *prefix) {
+  unsigned long shard, offset, size, nb_shards = 0;
+  char *filename = malloc(strlen(prefix) + 24);
+  randdag_reader_t *r = _new_reader(0);
+  FILE *index;
+  int n;
+
+  sprintf(filename, "%s.idx", prefix);
+  index = fopen(filename, "r");
+  free(filename);
+  if (index == NULL) {
+    randdag_reader_close(r);
+    return NULL;
+  }
+
+  while ((n = fscanf(index, "%lu %lu %lu", &shard, &offset, &size)) == 3) {
+    /* The shards are numbered from 0 and none of them is empty, which bounds
+     * their number before allocating them. */
+    if (shard > r->len)
+      break;
+    _push(r, shard, offset, size);
+    if (shard + 1 > nb_shards)
+      nb_shards = shard + 1;
+  }
+  fclose(index);
+  if (n != EOF) {
+    randdag_reader_close(r);
+    return NULL;
+  }
+
+  /* The shards are mapped on demand. */
+  free(r->files);
+  r->files = calloc(nb_shards > 0 ? nb_shards : 1, sizeof(_file));
+  r->nb_files = nb_shards;
+  r->prefix = malloc(strlen(prefix) + 1);
+  strcpy(r->prefix, prefix);
+  return r;
+}
+
+unsigned long randdag_reader_len(const randdag_reader_t *r) {
+  return r->len;
+}
+
+int randdag_reader_get(randdag_reader_t *r, unsigned long i,
+                       randdag_csr_t *g) {
+  _file *f;
+
+  if (i >= r->len)
+    return -1;
+
+  f = &r->files[r->file[i]];
+  if (f->map == NULL && !f->error && r->prefix != NULL) {
+    char *filename = malloc(strlen(r->prefix) + 24);
+    sprintf(filename, "%s.%lu", r->prefix, r->file[i]);
+    _map(f, filename);
+    free(filename);
+  }
+
+  if (f->error || r->size[i] < HEADER || r->offset[i] > f->size ||
+      r->size[i] > f->size - r->offset[i])
+    return -1;
+  if (_graph_size(f->map + r->offset[i], r->size[i], g) != r->size[i])
+    return -1;
+  return 0;
+}
+
+void randdag_reader_close(randdag_reader_t *r) {
+  unsigned long i;
+
+  for (i = 0; i < r->nb_files; i++) {
+    if (r->files[i].map != NULL)
+      munmap((void *)r->files[i].map, r->files[i].size);
+  }
+  free(r->files);
+  free(r->prefix);
+  free(r->file);
+  free(r->offset);
+  free(r->size);
+  free(r);
+}
@@ -0,0 +1,95 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#include <gmp.h>
+
+#include "../../includes/common.h"
+
+#define MASK32 0xffffffffUL
+
+/* Philox4x32 constants. */
+#define PHILOX_M0 0xD2511F53UL
+#define PHILOX_M1 0xCD9E8D57UL
+#define PHILOX_W0 0x9E3779B9UL
+#define PHILOX_W1 0xBB67AE85UL
+
+/* Full 32x32 -> 64 bits multiplication. ANSI C gives us no 64-bit integer type
+ * so we split the operands in 16-bit halves. */
+static void mulhilo(unsigned long a, unsigned long b, unsigned long *hi,
+                    unsigned long *lo) {
+  const unsigned long a0 = a & 0xffff, a1 = a >> 16;
+  const unsigned long b0 = b & 0xffff, b1 = b >> 16;
+  const unsigned long p00 = a0 * b0, p01 = a0 * b1;
+  const unsigned long p10 = a1 * b0, p11 = a1 * b1;
+  const unsigned long mid = (p00 >> 16) + (p01 & 0xffff) + (p10 & 0xffff);
+
+  *lo = ((mid << 16) | (p00 & 0xffff)) & MASK32;
+  *hi = (p11 + (p01 >> 16) + (p10 >> 16) + (mid >> 16)) & MASK32;
+}
+
+void randdag_philox(const unsigned long key[2], const unsigned long ctr[4],
+                    unsigned long out[4]) {
+  int r;
+  unsigned long k0 = key[0] & MASK32, k1 = key[1] & MASK32;
+  unsigned long c0 = ctr[0] & MASK32, c1 = ctr[1] & MASK32;
+  unsigned long c2 = ctr[2] & MASK32, c3 = ctr[3] & MASK32;
+
+  for (r = 0; r < 10; r++) {
+    unsigned long hi0, lo0, hi1, lo1;
+    mulhilo(PHILOX_M0, c0, &hi0, &lo0);
+    mulhilo(PHILOX_M1, c2, &hi1, &lo1);
+    c0 = hi1 ^ c1 ^ k0;
+    c1 = lo1;
+    c2 = hi0 ^ c3 ^ k1;
+    c3 = lo0;
+    k0 = (k0 + PHILOX_W0) & MASK32;
+    k1 = (k1 + PHILOX_W1) & MASK32;
+  }
+
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+void randdag_seed_stream(gmp_randstate_t state, unsigned long seed,
+                         unsigned long index) {
+  int i, j;
+  unsigned long key[2], ctr[4], out[4];
+  mpz_t s;
+
+  /* The key is the master seed and the counter is (index, block number). On
+   * platforms where long is 32 bits wide, the upper words are zero. */
+  key[0] = seed & MASK32;
+  key[1] = (seed >> 16 >> 16) & MASK32;
+  ctr[0] = index & MASK32;
+  ctr[1] = (index >> 16 >> 16) & MASK32;
+  ctr[3] = 0;
+
+  /* Two blocks give a 256-bit seed. */
+  mpz_init(s);
+  for (i = 0; i < 2; i++) {
+    ctr[2] = i;
+    randdag_philox(key, ctr, out);
+    for (j = 0; j < 4; j++) {
+      mpz_mul_2exp(s, s, 32);
+      mpz_add_ui(s, s, out[j]);
+    }
+  }
+  gmp_randseed(state, s);
+  mpz_clear(s);
+}
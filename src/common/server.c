@@ -0,0 +1,561 @@
+#define _POSIX_C_SOURCE 200809L
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Sampling server and pipeline.
+ *
+ * The server listens on a Unix domain socket and hands the connections to a
+ * pool of worker threads. Each connection carries a sequence of requests,
+ * one per line:
+ *
+ *     <model> <n> <m> <k> <bound> <count> <seed> <format>
+ *
+ * where negative values of m, k and bound mean any number of edges, any
+ * number of sources and no bound, and format is one of dot, edges, bin and
+ * csr. The answer is either a line "ERR <message>" or a line "OK <count>"
+ * followed by the graphs, each of them being preceded by a line giving its
+ * size in bytes. The i-th graph is drawn from the i-th stream of the seed
+ * (see cli_sample), as with the command line options --seed and
+ * --count-samples, so that the answer only depends on the request.
+ *
+ * The counting information is kept in memory between requests, in one table
+ * per bound. The tables are filled completely (for all numbers of edges and
+ * sources) up to the largest number of vertices requested so far, which
+ * makes sampling read-only: any number of workers can sample from a table
+ * concurrently, and a table is only locked for writing when it must grow.
+ * With --max-mem, the estimated size of all the tables, as they will be once
+ * grown for a request, must fit in the budget, otherwise the request is
+ * rejected; so are the requests whose engine alone does not fit.
+ *
+ * The pipeline (run_pipe) shares the tables and the workers of the server but
+ * reads its jobs from the standard input, one per line:
+ *
+ *     <n> <m> <k> <bound> <count> <seed> <path>
+ *
+ * and writes the graphs of each job to the file <path>, one after the other.
+ * A completion record is printed on the standard output when a job is done,
+ * see run_pipe. */
+
+#include <stdio.h>
+#include <gmp.h>
+#include <errno.h>      /* errno, EINTR */
+#include <malloc.h>     /* malloc, free */
+#include <pthread.h>    /* pthread_* */
+#include <stdlib.h>     /* EXIT_SUCCESS, EXIT_FAILURE */
+#include <string.h>     /* strcmp, strlen, strcpy, strspn, memset */
+#include <sys/socket.h> /* socket, bind, listen, accept, send */
+#include <sys/un.h>     /* sockaddr_un */
+#include <unistd.h>     /* unlink, close */
+
+#include "cli.h"
+#include "memo.h"
+#include "progress.h"
+#include "writer.h"
+
+/* Maximum length of a request line, and of the queue of connections waiting
+ * for a worker. */
+#define REQUEST_LEN 256
+#define QUEUE_LEN 64
+/* Maximum length of a job line of the pipeline. */
+#define JOB_LEN 4096
+
+/* The counting information for one bound (negative for unbounded graphs),
+ * complete up to memo.N vertices. It is charged to the memory budget for
+ * planned_N vertices, which is at least memo.N. */
+typedef struct _table {
+  int bound;
+  memo_t memo;
+  int planned_N;
+  double bytes;
+  pthread_rwlock_t lock;
+  struct _table *next;
+} _table;
+
+/* What the server and the pipeline have in common: the model and its
+ * tables. */
+typedef struct {
+  const char *model;
+  __counter_t counter;
+  __sampler_t sampler;
+  __planner_t planner;
+  /* The memory budget, see --max-mem (0 for no limit). */
+  size_t max_bytes;
+  long flags;
+  /* Passed to the sampler when it does not need the counting information. */
+  memo_t empty;
+
+  /* The tables, created on demand and never freed, and their estimated
+   * size. */
+  _table *tables;
+  double bytes;
+  pthread_mutex_t tables_lock;
+} _context;
+
+typedef struct {
+  _context c;
+
+  /* The connections waiting for a worker. */
+  int queue[QUEUE_LEN];
+  int head, len;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+} _server;
+
+typedef struct {
+  _context c;
+  int format;
+
+  /* The jobs are read by the workers, one at a time. */
+  FILE *in;
+  unsigned long line;
+  pthread_mutex_t in_lock;
+  /* Serialises the completion records. */
+  pthread_mutex_t out_lock;
+  int failed;
+} _pipe;
+
+static void _context_init(_context *s, const char *model, __counter_t counter,
+                          __sampler_t sampler, __planner_t planner,
+                          size_t max_bytes, long flags) {
+  s->model = model;
+  s->counter = counter;
+  s->sampler = sampler;
+  s->planner = planner;
+  s->max_bytes = max_bytes;
+  s->flags = flags;
+  s->empty = memo_alloc(0, 0, -1);
+  s->tables = NULL;
+  s->bytes = 0;
+  pthread_mutex_init(&s->tables_lock, NULL);
+}
+
+/* Return the table for the given bound, filled up to at least n vertices,
+ * locked for reading, or NULL if the tables would not fit in the memory
+ * budget. */
+static _table *_get_table(_context *s, int n, int bound) {
+  _table *t;
+
+  if (bound < 0)
+    bound = -1;
+
+  pthread_mutex_lock(&s->tables_lock);
+  for (t = s->tables; t != NULL && t->bound != bound; t = t->next)
+    ;
+  if (t == NULL) {
+    t = malloc(sizeof(_table));
+    t->bound = bound;
+    t->memo = memo_alloc(0, -1, bound);
+    t->planned_N = 0;
+    t->bytes = 0;
+    pthread_rwlock_init(&t->lock, NULL);
+    t->next = s->tables;
+    s->tables = t;
+  }
+  /* Charge the growth of the table to the budget before doing it. */
+  if (n > t->planned_N) {
+    const double bytes = memo_plan(s->model, n, -1, bound, 0, 1, 0).dense;
+    if (s->max_bytes > 0 && s->bytes - t->bytes + bytes > s->max_bytes) {
+      pthread_mutex_unlock(&s->tables_lock);
+      return NULL;
+    }
+    s->bytes += bytes - t->bytes;
+    t->bytes = bytes;
+    t->planned_N = n;
+  }
+  pthread_mutex_unlock(&s->tables_lock);
+
+  pthread_rwlock_rdlock(&t->lock);
+  while (t->memo.N < n) {
+    pthread_rwlock_unlock(&t->lock);
+    pthread_rwlock_wrlock(&t->lock);
+    /* Another worker may have grown the table in the meantime. */
+    if (t->memo.N < n) {
+      int l;
+      const int N = t->memo.N;
+      t->memo = memo_extend(t->memo, n, -1, bound);
+      for (l = N + 1; l <= n; l++)
+        memo_fill_layer(t->memo, s->counter, l);
+    }
+    pthread_rwlock_unlock(&t->lock);
+    pthread_rwlock_rdlock(&t->lock);
+  }
+
+  return t;
+}
+
+/* Prepare the sampling of count graphs with n vertices, m edges, k sources
+ * and out-degrees bounded by bound: *engine is set to the engine chosen by
+ * the planner, *t to the table to sample from, or to NULL if the engine does
+ * not need one, and *w to the window of the parameters in that table. Return
+ * an error message, or NULL on success. */
+static const char *_prepare(_context *s, int n, int m, int k, int bound,
+                            unsigned long count, int *engine, _table **t,
+                            window_t *w) {
+  sampler_plan_t plan;
+
+  *t = NULL;
+  /* The samplers abort on parameters for which there is no graph. */
+  if (n < 0)
+    return "no graph with these parameters";
+  plan = s->planner(n, m, k, bound, count, s->max_bytes);
+  if (!plan.fits)
+    return "does not fit in the memory budget";
+  *engine = plan.engine;
+  if (plan.needs_memo) {
+    if ((*t = _get_table(s, n, bound)) == NULL)
+      return "does not fit in the memory budget";
+    *w = window_alloc((*t)->memo, s->counter, n, n, m, m, k, k, bound);
+    pthread_rwlock_unlock(&(*t)->lock);
+    if (w->len == 0) {
+      window_free(*w);
+      *t = NULL;
+      return "no graph with these parameters";
+    }
+  }
+  return NULL;
+}
+
+/* Draw the i-th graph of a request prepared by _prepare. */
+static randdag_t _draw(_context *s, int engine, gmp_randstate_t state,
+                       _table *t, const window_t *w, int n, int m, int k,
+                       int bound, unsigned long seed, unsigned long i) {
+  randdag_t g;
+  if (t == NULL)
+    return cli_sample(s->sampler, engine, state, s->empty, NULL, n, m, k,
+                      bound, seed, i);
+  /* The table may grow, but not shrink, in the meantime. */
+  pthread_rwlock_rdlock(&t->lock);
+  g = cli_sample(s->sampler, engine, state, t->memo, w, n, m, k, bound, seed,
+                 i);
+  pthread_rwlock_unlock(&t->lock);
+  return g;
+}
+
+/* --- Server ------------------------------------------------------------- */
+
+/* Send the whole buffer. Return 0 on success and -1 if the client is gone. */
+static int _send(int fd, const char *buf, size_t len) {
+  while (len > 0) {
+    const ssize_t r = send(fd, buf, len, MSG_NOSIGNAL);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return -1;
+    buf += r;
+    len -= r;
+  }
+  return 0;
+}
+
+static int _send_str(int fd, const char *str) {
+  return _send(fd, str, strlen(str));
+}
+
+/* Answer one request. Return -1 if the connection must be closed. */
+static int _request(_context *s, int fd, gmp_randstate_t state,
+                    const char *line) {
+  char model[32], fmt[16], header[32];
+  int n, m, k, bound, format, engine, error = 0;
+  long signed_count;
+  unsigned long i, count, seed;
+  const char *msg;
+  _table *t;
+  window_t w;
+  writer_t out;
+
+  /* %lu would silently read a negative count as a huge one. */
+  if (sscanf(line, "%31s %d %d %d %d %ld %lu %15s", model, &n, &m, &k, &bound,
+             &signed_count, &seed, fmt) != 8 ||
+      signed_count < 0)
+    return _send_str(fd, "ERR malformed request\n");
+  count = signed_count;
+  if (strcmp(model, s->model) != 0)
+    return _send_str(fd, "ERR unknown model\n");
+
+  if (strcmp(fmt, "dot") == 0)
+    format = RD_FMT_DOT;
+  else if (strcmp(fmt, "edges") == 0)
+    format = RD_FMT_EDGES;
+  else if (strcmp(fmt, "bin") == 0)
+    format = RD_FMT_BIN_EDGES;
+  else if (strcmp(fmt, "csr") == 0)
+    format = RD_FMT_CSR;
+  else
+    return _send_str(fd, "ERR unknown format\n");
+
+  if ((msg = _prepare(s, n, m, k, bound, count, &engine, &t, &w)) != NULL) {
+    char answer[64];
+    sprintf(answer, "ERR %s\n", msg);
+    return _send_str(fd, answer);
+  }
+
+  sprintf(header, "OK %lu\n", count);
+  error = _send_str(fd, header) != 0;
+
+  writer_init_mem(&out);
+  for (i = 0; !error && i < count; i++) {
+    randdag_t g = _draw(s, engine, state, t, &w, n, m, k, bound, seed, i);
+    out.len = 0;
+    randdag_write_w(&out, g, format, s->flags);
+    randdag_free(g);
+    sprintf(header, "%lu\n", (unsigned long)out.len);
+    error = _send_str(fd, header) != 0 || _send(fd, out.buf, out.len) != 0;
+  }
+  writer_close(&out);
+  if (t != NULL)
+    window_free(w);
+
+  return error ? -1 : 0;
+}
+
+/* Answer the requests of a connection until the client closes it. */
+static void _connection(_context *s, int fd, gmp_randstate_t state) {
+  char line[REQUEST_LEN];
+  FILE *in = fdopen(fd, "r");
+
+  if (in == NULL) {
+    close(fd);
+    return;
+  }
+
+  while (fgets(line, REQUEST_LEN, in) != NULL) {
+    if (strchr(line, '\n') == NULL && !feof(in)) {
+      _send_str(fd, "ERR request too long\n");
+      break;
+    }
+    if (_request(s, fd, state, line) != 0)
+      break;
+  }
+
+  /* Also closes fd. */
+  fclose(in);
+}
+
+static void *_worker(void *arg) {
+  _server *s = arg;
+  gmp_randstate_t state;
+
+  gmp_randinit_default(state);
+  while (1) {
+    int fd;
+
+    pthread_mutex_lock(&s->lock);
+    while (s->len == 0)
+      pthread_cond_wait(&s->cond, &s->lock);
+    fd = s->queue[s->head];
+    s->head = (s->head + 1) % QUEUE_LEN;
+    s->len--;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+
+    _connection(&s->c, fd, state);
+  }
+
+  /* Not reached. */
+  gmp_randclear(state);
+  return NULL;
+}
+
+int run_server(const char *path, int threads, const char *model,
+               __counter_t counter, __sampler_t sampler,
+               __planner_t planner, size_t max_bytes, long flags) {
+  int i, fd;
+  struct sockaddr_un addr;
+  _server *s;
+
+  /* Set up the socket, replacing a stale one from a previous run. */
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Socket path too long: \"%s\"\n", path);
+    return EXIT_FAILURE;
+  }
+  strcpy(addr.sun_path, path);
+  unlink(path);
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(fd, QUEUE_LEN) != 0) {
+    fprintf(stderr, "Cannot listen on \"%s\"\n", path);
+    return EXIT_FAILURE;
+  }
+
+  s = malloc(sizeof(_server));
+  _context_init(&s->c, model, counter, sampler, planner, max_bytes, flags);
+  s->head = s->len = 0;
+  pthread_mutex_init(&s->lock, NULL);
+  pthread_cond_init(&s->cond, NULL);
+  for (i = 0; i < threads; i++) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, _worker, s);
+    pthread_detach(thread);
+  }
+
+  fprintf(stderr, "Serving %s graphs on \"%s\" with %d threads\n", model,
+          path, threads);
+  while (1) {
+    const int client = accept(fd, NULL, NULL);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      fprintf(stderr, "Cannot accept connections on \"%s\"\n", path);
+      close(fd);
+      return EXIT_FAILURE;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    while (s->len == QUEUE_LEN)
+      pthread_cond_wait(&s->cond, &s->lock);
+    s->queue[(s->head + s->len) % QUEUE_LEN] = client;
+    s->len++;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+  }
+}
+
+/* --- Pipeline ----------------------------------------------------------- */
+
+/* Run the job of a line of the input, setting *count to its number of graphs
+ * and *path to its output file. Return an error message, or NULL on
+ * success. */
+static const char *_job(_pipe *p, gmp_randstate_t state, char *line,
+                        unsigned long *count, const char **path) {
+  int n, m, k, bound, engine, pos = -1;
+  long signed_count;
+  unsigned long i, seed;
+  size_t len;
+  const char *msg;
+  _table *t;
+  window_t w;
+  writer_t out;
+  FILE *fd;
+
+  if (sscanf(line, "%d %d %d %d %ld %lu %n", &n, &m, &k, &bound,
+             &signed_count, &seed, &pos) != 6 ||
+      pos < 0 || signed_count < 0)
+    return "malformed job";
+  *count = signed_count;
+  /* The path is the rest of the line. */
+  *path = line + pos;
+  len = strcspn(*path, "\r\n");
+  line[pos + len] = '\0';
+  if (len == 0)
+    return "malformed job";
+
+  if ((msg = _prepare(&p->c, n, m, k, bound, *count, &engine, &t, &w)) !=
+      NULL)
+    return msg;
+
+  fd = fopen(*path, "w");
+  if (fd == NULL) {
+    msg = "cannot open the output file";
+  } else {
+    /* One buffer for all the graphs of the job. */
+    int error;
+    writer_init(&out, fd);
+    for (i = 0; !out.error && i < *count; i++) {
+      randdag_t g =
+          _draw(&p->c, engine, state, t, &w, n, m, k, bound, seed, i);
+      randdag_write_w(&out, g, p->format, p->c.flags);
+      randdag_free(g);
+    }
+    error = writer_close(&out) != 0;
+    if (fclose(fd) != 0 || error)
+      msg = "error while writing the output file";
+  }
+  if (t != NULL)
+    window_free(w);
+  return msg;
+}
+
+static void *_pipe_worker(void *arg) {
+  _pipe *p = arg;
+  char line[JOB_LEN];
+  gmp_randstate_t state;
+
+  gmp_randinit_default(state);
+  while (1) {
+    int got, too_long = 0;
+    unsigned long nb, count = 0;
+    const char *msg, *path = "";
+    double start;
+
+    /* Read the next job and number it after its line. */
+    pthread_mutex_lock(&p->in_lock);
+    got = fgets(line, JOB_LEN, p->in) != NULL;
+    nb = ++p->line;
+    if (got && strchr(line, '\n') == NULL && !feof(p->in)) {
+      int c;
+      too_long = 1;
+      while ((c = getc(p->in)) != '\n' && c != EOF)
+        ;
+    }
+    pthread_mutex_unlock(&p->in_lock);
+
+    if (!got)
+      break;
+    if (line[strspn(line, " \t\r\n")] == '\0')
+      continue;
+
+    start = progress_now();
+    msg = too_long ? "job too long" : _job(p, state, line, &count, &path);
+
+    pthread_mutex_lock(&p->out_lock);
+    if (msg != NULL) {
+      printf("%lu ERR %s\n", nb, msg);
+      p->failed = 1;
+    } else {
+      printf("%lu OK %lu %.3f %s\n", nb, count, progress_now() - start, path);
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(&p->out_lock);
+  }
+
+  gmp_randclear(state);
+  return NULL;
+}
+
+int run_pipe(int threads, const char *model, __counter_t counter,
+             __sampler_t sampler, __planner_t planner, size_t max_bytes,
+             long flags, int format) {
+  int i;
+  _pipe p;
+  _table *t;
+  pthread_t *ids = malloc(threads * sizeof(pthread_t));
+
+  _context_init(&p.c, model, counter, sampler, planner, max_bytes, flags);
+  p.format = format;
+  p.in = stdin;
+  p.line = 0;
+  p.failed = 0;
+  pthread_mutex_init(&p.in_lock, NULL);
+  pthread_mutex_init(&p.out_lock, NULL);
+
+  for (i = 0; i < threads; i++)
+    pthread_create(&ids[i], NULL, _pipe_worker, &p);
+  for (i = 0; i < threads; i++)
+    pthread_join(ids[i], NULL);
+
+  while ((t = p.c.tables) != NULL) {
+    p.c.tables = t->next;
+    memo_free(t->memo);
+    pthread_rwlock_destroy(&t->lock);
+    free(t);
+  }
+  memo_free(p.c.empty);
+  free(ids);
+  return p.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,247 @@
+#define _POSIX_C_SOURCE 200809L
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Output of many graphs to rotating shard files.
+ *
+ * The graphs are formatted in memory by the sampling thread, into one of two
+ * blocks of a few MiB. When a block is full, it is handed to a background
+ * thread that writes it to disk while the other block is being filled, so
+ * that sampling only waits for the disk if it is faster than it. A block
+ * always belongs to a single shard: it is handed over early when the shard
+ * changes. */
+
+#include <malloc.h>  /* malloc, free */
+#include <pthread.h> /* pthread_* */
+#include <stdio.h>   /* fopen, fwrite, sprintf */
+#include <string.h>  /* strlen, strcpy */
+
+#include "../../includes/common.h"
+#include "writer.h"
+
+/* Size above which a block is handed to the background thread. */
+#define SHARDS_BLOCK (1 << 22)
+
+typedef struct {
+  /* The formatted graphs and the corresponding lines of the index. */
+  writer_t data, index;
+  /* The shard the graphs belong to. */
+  unsigned long shard;
+} _block;
+
+struct randdag_shards {
+  char *prefix;
+  int format;
+  unsigned int flags;
+  unsigned long max_bytes, max_graphs;
+
+  /* State of the sampling thread: the block being filled, the current
+   * shard, its size and number of graphs so far, and a writer for
+   * formatting one graph. */
+  _block blocks[2];
+  int filling;
+  unsigned long shard, shard_bytes, shard_graphs;
+  writer_t graph;
+
+  /* Hand-over to the background thread: `full` is set while a block is
+   * waiting for or being written. */
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  _block *pending;
+  int full, stop;
+
+  /* State of the background thread. */
+  FILE *index, *fd;
+  unsigned long fd_shard;
+  int error;
+};
+
+/* Write a block to its shard, opening the shard if needed. */
+static void _write_block(randdag_shards_t *s, _block *b) {
+  if (s->fd == NULL || s->fd_shard != b->shard) {
+    char *filename = malloc(strlen(s->prefix) + 24);
+    if (s->fd != NULL && fclose(s->fd) != 0)
+      s->error = 1;
+    sprintf(filename, "%s.%lu", s->prefix, b->shard);
+    s->fd = fopen(filename, "wb");
+    s->fd_shard = b->shard;
+    free(filename);
+    if (s->fd == NULL) {
+      s->error = 1;
+      return;
+    }
+  }
+
+  if (fwrite(b->data.buf, 1, b->data.len, s->fd) != b->data.len ||
+      fwrite(b->index.buf, 1, b->index.len, s->index) != b->index.len)
+    s->error = 1;
+}
+
+static void *_writer_thread(void *arg) {
+  randdag_shards_t *s = arg;
+
+  pthread_mutex_lock(&s->lock);
+  while (1) {
+    _block *b;
+    while (!s->full && !s->stop)
+      pthread_cond_wait(&s->cond, &s->lock);
+    if (!s->full)
+      break;
+    b = s->pending;
+    pthread_mutex_unlock(&s->lock);
+
+    _write_block(s, b);
+
+    pthread_mutex_lock(&s->lock);
+    s->full = 0;
+    pthread_cond_broadcast(&s->cond);
+  }
+  pthread_mutex_unlock(&s->lock);
+  return NULL;
+}
+
+/* Hand the block being filled to the background thread, once it is done with
+ * the previous one, and switch to the other block. */
+static void _hand_over(randdag_shards_t *s) {
+  _block *b = &s->blocks[s->filling];
+
+  if (b->data.len == 0 && b->index.len == 0)
+    return;
+
+  pthread_mutex_lock(&s->lock);
+  while (s->full)
+    pthread_cond_wait(&s->cond, &s->lock);
+  s->pending = b;
+  s->full = 1;
+  pthread_cond_broadcast(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+
+  /* The background thread is done with the other block. */
+  s->filling = 1 - s->filling;
+  b = &s->blocks[s->filling];
+  b->data.len = 0;
+  b->index.len = 0;
+  b->shard = s->shard;
+}
+
+randdag_shards_t *randdag_shards_open(const char *prefix, int format,
+                                      unsigned int flags,
+                                      unsigned long max_bytes,
+                                      unsigned long max_graphs) {
+  int i;
+  char *filename = malloc(strlen(prefix) + 5);
+  randdag_shards_t *s = malloc(sizeof(randdag_shards_t));
+
+  sprintf(filename, "%s.idx", prefix);
+  s->index = fopen(filename, "w");
+  free(filename);
+  if (s->index == NULL) {
+    free(s);
+    return NULL;
+  }
+
+  s->prefix = malloc(strlen(prefix) + 1);
+  strcpy(s->prefix, prefix);
+  s->format = format;
+  s->flags = flags;
+  s->max_bytes = max_bytes;
+  s->max_graphs = max_graphs;
+
+  for (i = 0; i < 2; i++) {
+    writer_init_mem(&s->blocks[i].data);
+    writer_init_mem(&s->blocks[i].index);
+    s->blocks[i].shard = 0;
+  }
+  s->filling = 0;
+  s->shard = s->shard_bytes = s->shard_graphs = 0;
+  writer_init_mem(&s->graph);
+
+  s->fd = NULL;
+  s->fd_shard = 0;
+  s->error = 0;
+  s->pending = NULL;
+  s->full = s->stop = 0;
+  pthread_mutex_init(&s->lock, NULL);
+  pthread_cond_init(&s->cond, NULL);
+  pthread_create(&s->thread, NULL, _writer_thread, s);
+
+  return s;
+}
+
+int randdag_shards_write(randdag_shards_t *s, const randdag_t g) {
+  _block *b;
+  int error;
+
+  s->graph.len = 0;
+  randdag_write_w(&s->graph, g, s->format, s->flags);
+  error = s->graph.error;
+
+  /* Start a new shard if this graph does not fit in the current one. */
+  if (s->shard_graphs > 0 &&
+      ((s->max_graphs > 0 && s->shard_graphs >= s->max_graphs) ||
+       (s->max_bytes > 0 && s->shard_bytes + s->graph.len > s->max_bytes))) {
+    _hand_over(s);
+    s->shard++;
+    s->shard_bytes = s->shard_graphs = 0;
+    s->blocks[s->filling].shard = s->shard;
+  }
+
+  b = &s->blocks[s->filling];
+  writer_uint(&b->index, s->shard);
+  writer_char(&b->index, ' ');
+  writer_uint(&b->index, s->shard_bytes);
+  writer_char(&b->index, ' ');
+  writer_uint(&b->index, s->graph.len);
+  writer_char(&b->index, '\n');
+  writer_bytes(&b->data, s->graph.buf, s->graph.len);
+  s->shard_bytes += s->graph.len;
+  s->shard_graphs++;
+
+  if (b->data.len >= SHARDS_BLOCK)
+    _hand_over(s);
+
+  return error ? -1 : 0;
+}
+
+int randdag_shards_close(randdag_shards_t *s) {
+  int i, error;
+
+  _hand_over(s);
+  pthread_mutex_lock(&s->lock);
+  s->stop = 1;
+  pthread_cond_broadcast(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+  pthread_join(s->thread, NULL);
+
+  error = s->error;
+  if (s->fd != NULL)
+    error |= (fclose(s->fd) != 0);
+  error |= (fclose(s->index) != 0);
+
+  for (i = 0; i < 2; i++) {
+    writer_close(&s->blocks[i].data);
+    writer_close(&s->blocks[i].index);
+  }
+  writer_close(&s->graph);
+  pthread_mutex_destroy(&s->lock);
+  pthread_cond_destroy(&s->cond);
+  free(s->prefix);
+  free(s);
+
+  return error ? -1 : 0;
+}
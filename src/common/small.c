@@ -0,0 +1,100 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#include <malloc.h> /* calloc, malloc, free */
+
+#include <gmp.h>
+
+#include "small.h"
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+small_table *small_table_new(void) {
+  small_table *t = malloc(sizeof(small_table));
+  t->N = -1;
+  t->vals = NULL;
+  return t;
+}
+
+void small_table_free(small_table *t) {
+  int n, k;
+
+  for (n = 2; n <= t->N; n++) {
+    for (k = 1; k <= n; k++)
+      free(t->vals[n - 2][k - 1]);
+    free(t->vals[n - 2]);
+  }
+  free(t->vals);
+  free(t);
+}
+
+int small_table_N(memo_t memo, int threshold) {
+  int n, k;
+  small_table *t = memo.small;
+
+  if (t->N >= 0)
+    return t->N;
+
+  /* Same shape as memo.vals, restricted to n <= threshold. */
+  t->N = (SMALL_BITS == 0) ? 1 : min(threshold, memo.N);
+  t->vals = calloc(t->N > 1 ? t->N - 1 : 1, sizeof(small_t **));
+  for (n = 2; n <= t->N; n++) {
+    t->vals[n - 2] = calloc(n, sizeof(small_t *));
+    for (k = 1; k <= n; k++) {
+      const int C = min(memo.bound, n - k);
+      const int max_m = min((C - 1) * C / 2 + C * (n - C), memo.M);
+      t->vals[n - 2][k - 1] = calloc(max_m + 1, sizeof(small_t));
+    }
+  }
+
+  return t->N;
+}
+
+int small_threshold(const int *thresholds, int len, int bound) {
+  return thresholds[min(bound, len - 1)];
+}
+
+void small_get_mpz(mpz_t z, small_t x) {
+  int s;
+
+  mpz_set_ui(z, 0);
+  for (s = SMALL_BITS - 32; s >= 0; s -= 32) {
+    mpz_mul_2exp(z, z, 32);
+    mpz_add_ui(z, z, (unsigned long)((x >> s) & 0xffffffffUL));
+  }
+}
+
+small_t small_urandomm(gmp_randstate_t state, small_t x) {
+  int bits, s;
+  small_t r;
+
+  if (x <= ULONG_MAX)
+    return gmp_urandomm_ui(state, (unsigned long)x);
+
+  /* Rejection: draw bits random bits, 32 at a time, until r < x. */
+  for (bits = 0; ((x - 1) >> bits) > 0; bits++) {
+  }
+  do {
+    r = 0;
+    for (s = 0; s < bits; s += 32) {
+      const int b = min(32, bits - s);
+      r = (r << b) | gmp_urandomb_ui(state, b);
+    }
+  } while (r >= x);
+
+  return r;
+}
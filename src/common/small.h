@@ -0,0 +1,80 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef _RANDDAG_SMALL_H
+#define _RANDDAG_SMALL_H
+
+/* Machine-integer fast path for small values of n.
+ *
+ * For small graphs, all the counts fit in a machine word and the overhead of
+ * GMP dominates the cost of counting and sampling. Each memo_t thus carries a
+ * table of machine integers, filled on demand, for the values of n below a
+ * threshold that depends on the model and on the bound. The thresholds are
+ * precomputed so that no intermediate value of the counting and sampling
+ * algorithms (including sums over all k and m, and the products by n done in
+ * the LDAG recurrence) can overflow. */
+
+#include <limits.h> /* ULONG_MAX */
+
+#include <gmp.h>
+
+#include "../../includes/common.h"
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 small_t;
+#define SMALL_BITS 128
+#elif (ULONG_MAX >> 31 >> 31) == 3
+typedef unsigned long small_t;
+#define SMALL_BITS 64
+#else
+/* No machine integer type is large enough to be useful, disable the fast path.
+ */
+typedef unsigned long small_t;
+#define SMALL_BITS 0
+#endif
+
+/* The table of machine integers attached to a memo_t (its `small` field). Its
+ * N field is negative until the table is allocated. */
+typedef struct {
+  int N;
+  small_t ***vals;
+} small_table;
+
+#define small_get_ptr(table, n, m, k) (&((table)->vals[(n)-2][(k)-1][m]))
+
+/* Allocate an empty (and unallocated) table. */
+small_table *small_table_new(void);
+
+/* Free a table and its content. */
+void small_table_free(small_table *);
+
+/* Return the size of the small table of memo, given the threshold of the
+ * model for this memo's bound. Allocate the table on the first call. */
+int small_table_N(memo_t, int threshold);
+
+/* Pick the threshold corresponding to a bound in one of the per-model tables
+ * of thresholds, indexed by the bound. The last entry of such a table is used
+ * for larger bounds. */
+int small_threshold(const int *thresholds, int len, int bound);
+
+/* Store a machine integer into a GMP integer. */
+void small_get_mpz(mpz_t, small_t);
+
+/* Uniform machine integer in [0; x[. */
+small_t small_urandomm(gmp_randstate_t, small_t x);
+
+#endif
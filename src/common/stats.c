@@ -0,0 +1,440 @@
+#define _POSIX_C_SOURCE 200809L
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+/* Statistics of many graphs, aggregated on the fly.
+ *
+ * All the statistics take non-negative integer values, but some of them range
+ * over large intervals: the number of edges of a graph with n vertices can be
+ * about n^2 / 2. Each statistic thus keeps the exact sum of its values and of
+ * their squares, from which its mean and standard deviation are derived, and
+ * an exact histogram that is dense for small values and sparse (a hash table)
+ * above, so that its size is linear in the number of distinct values seen
+ * and not in their range. Merging two aggregates adds their sums and their
+ * histograms, which is what allows the threads of randdag_stats_sample to
+ * work independently. */
+
+#include <stdio.h>
+#include <stdlib.h>  /* qsort */
+#include <gmp.h>
+#include <malloc.h>  /* malloc, calloc, free */
+#include <math.h>    /* sqrt */
+#include <pthread.h> /* pthread_create, pthread_join */
+#include <string.h>  /* strlen, strncmp */
+
+#include "../../includes/common.h"
+
+#define max(x, y) (((x) < (y)) ? (y) : (x))
+
+#define NB_STATS 8
+
+/* The values below DENSE_LEN are counted in an array, the others in a hash
+ * table. */
+#define DENSE_LEN 1024
+
+static const char *const _names[NB_STATS] = {
+    "edges",          "sources",       "sinks",      "depth",
+    "max-out-degree", "max-in-degree", "out-degree", "in-degree"};
+
+/* A value and its number of occurrences. In the hash tables, nb == 0 marks an
+ * empty slot. */
+typedef struct {
+  unsigned long v, nb;
+} _entry;
+
+struct randdag_stats {
+  unsigned int which;
+  /* total[s] is the number of values of the s-th statistic, sum[s] and sq[s]
+   * the sum of these values and of their squares. */
+  unsigned long total[NB_STATS];
+  mpz_t sum[NB_STATS], sq[NB_STATS];
+  /* dense[s][v] is the number of occurrences of the value v < DENSE_LEN of
+   * the s-th statistic. */
+  unsigned long dense[NB_STATS][DENSE_LEN];
+  /* The larger values, in a hash table of cap[s] slots (a power of two, or
+   * 0), used[s] of which are taken. */
+  _entry *sparse[NB_STATS];
+  unsigned long cap[NB_STATS], used[NB_STATS];
+  /* Scratch integer for _add. */
+  mpz_t tmp;
+};
+
+unsigned int randdag_stats_flags(const char *list) {
+  unsigned int which = 0;
+
+  while (1) {
+    int s;
+    const char *end = list;
+    size_t len;
+
+    while (*end != ',' && *end != '\0')
+      end++;
+    len = end - list;
+
+    if (len == 3 && strncmp(list, "all", 3) == 0) {
+      which |= RD_STAT_ALL;
+    } else {
+      for (s = 0; s < NB_STATS; s++) {
+        if (strlen(_names[s]) == len && strncmp(list, _names[s], len) == 0)
+          break;
+      }
+      if (s == NB_STATS)
+        return 0;
+      which |= 1u << s;
+    }
+
+    if (*end == '\0')
+      return which;
+    list = end + 1;
+  }
+}
+
+randdag_stats_t *randdag_stats_alloc(unsigned int which) {
+  int s;
+  randdag_stats_t *stats = calloc(1, sizeof(randdag_stats_t));
+
+  stats->which = which & RD_STAT_ALL;
+  for (s = 0; s < NB_STATS; s++) {
+    mpz_init(stats->sum[s]);
+    mpz_init(stats->sq[s]);
+  }
+  mpz_init(stats->tmp);
+  return stats;
+}
+
+void randdag_stats_free(randdag_stats_t *stats) {
+  int s;
+  for (s = 0; s < NB_STATS; s++) {
+    mpz_clear(stats->sum[s]);
+    mpz_clear(stats->sq[s]);
+    free(stats->sparse[s]);
+  }
+  mpz_clear(stats->tmp);
+  free(stats);
+}
+
+/* The slot of the value v in a hash table of cap slots: either the slot
+ * holding v or the empty slot where it should be inserted. */
+static unsigned long _slot(const _entry *table, unsigned long cap,
+                           unsigned long v) {
+  unsigned long i = v ^ (v >> 16);
+  i = ((i * 0x45d9f3bUL) ^ (i >> 16)) & (cap - 1);
+  while (table[i].nb > 0 && table[i].v != v)
+    i = (i + 1) & (cap - 1);
+  return i;
+}
+
+/* Add nb occurrences of the value v of the s-th statistic to its histogram
+ * only. */
+static void _count(randdag_stats_t *stats, int s, unsigned long v,
+                   unsigned long nb) {
+  unsigned long i;
+  _entry *table;
+
+  if (v < DENSE_LEN) {
+    stats->dense[s][v] += nb;
+    return;
+  }
+
+  /* Keep the load factor of the hash table below 1/2. */
+  if (2 * (stats->used[s] + 1) > stats->cap[s]) {
+    const unsigned long cap = max(2 * stats->cap[s], 16);
+    table = calloc(cap, sizeof(_entry));
+    for (i = 0; i < stats->cap[s]; i++) {
+      const _entry e = stats->sparse[s][i];
+      if (e.nb > 0)
+        table[_slot(table, cap, e.v)] = e;
+    }
+    free(stats->sparse[s]);
+    stats->sparse[s] = table;
+    stats->cap[s] = cap;
+  }
+
+  table = stats->sparse[s];
+  i = _slot(table, stats->cap[s], v);
+  if (table[i].nb == 0) {
+    table[i].v = v;
+    stats->used[s]++;
+  }
+  table[i].nb += nb;
+}
+
+/* Add nb occurrences of the value v of the s-th statistic. */
+static void _add(randdag_stats_t *stats, int s, unsigned long v,
+                 unsigned long nb) {
+  _count(stats, s, v, nb);
+  stats->total[s] += nb;
+  mpz_set_ui(stats->tmp, v);
+  mpz_addmul_ui(stats->sum[s], stats->tmp, nb);
+  mpz_mul_ui(stats->tmp, stats->tmp, v);
+  mpz_addmul_ui(stats->sq[s], stats->tmp, nb);
+}
+
+void randdag_stats_add(randdag_stats_t *stats, const randdag_t g) {
+  int i, j, min_id, head = 0, tail = 0;
+  int nb_sinks = 0, max_out = 0, max_in = 0, depth = 0;
+  unsigned long nb_edges = 0;
+  int *pos, *in_degree, *d, *queue;
+  const unsigned int which = stats->which;
+
+  if (which == 0)
+    return;
+
+  /* The vertices are numbered from 0 by subtracting the smallest id, see
+   * randdag_write. */
+  min_id = g.N > 0 ? g.v[0].id : 0;
+  for (i = 1; i < g.N; i++) {
+    if (g.v[i].id < min_id)
+      min_id = g.v[i].id;
+  }
+  pos = malloc((g.N > 0 ? g.N : 1) * sizeof(int));
+  in_degree = calloc(g.N > 0 ? g.N : 1, sizeof(int));
+  d = calloc(g.N > 0 ? g.N : 1, sizeof(int));
+  queue = malloc((g.N > 0 ? g.N : 1) * sizeof(int));
+
+  for (i = 0; i < g.N; i++) {
+    const randdag_vertex u = g.v[i];
+    pos[u.id - min_id] = i;
+    nb_edges += u.out_degree;
+    nb_sinks += (u.out_degree == 0);
+    max_out = max(max_out, u.out_degree);
+    for (j = 0; j < u.out_degree; j++)
+      in_degree[u.out_edges[j].id - min_id]++;
+    if (which & RD_STAT_OUT_DEGREE)
+      _add(stats, 6, u.out_degree, 1);
+  }
+
+  /* The sources are the first vertices of a topological order. */
+  for (i = 0; i < g.N; i++) {
+    max_in = max(max_in, in_degree[i]);
+    if (in_degree[i] == 0)
+      queue[tail++] = i;
+    if (which & RD_STAT_IN_DEGREE)
+      _add(stats, 7, in_degree[i], 1);
+  }
+
+  if (which & RD_STAT_EDGES)
+    _add(stats, 0, nb_edges, 1);
+  if (which & RD_STAT_SOURCES)
+    _add(stats, 1, tail, 1);
+  if (which & RD_STAT_SINKS)
+    _add(stats, 2, nb_sinks, 1);
+  if (which & RD_STAT_MAX_OUT)
+    _add(stats, 4, max_out, 1);
+  if (which & RD_STAT_MAX_IN)
+    _add(stats, 5, max_in, 1);
+
+  /* Longest paths, in topological order (Kahn's algorithm). */
+  if (which & RD_STAT_DEPTH) {
+    while (head < tail) {
+      const int x = queue[head++];
+      const randdag_vertex u = g.v[pos[x]];
+      depth = max(depth, d[x]);
+      for (j = 0; j < u.out_degree; j++) {
+        const int y = u.out_edges[j].id - min_id;
+        d[y] = max(d[y], d[x] + 1);
+        if (--in_degree[y] == 0)
+          queue[tail++] = y;
+      }
+    }
+    _add(stats, 3, depth, 1);
+  }
+
+  free(pos);
+  free(in_degree);
+  free(d);
+  free(queue);
+}
+
+void randdag_stats_merge(randdag_stats_t *dst, const randdag_stats_t *src) {
+  int s;
+  unsigned long i;
+
+  for (s = 0; s < NB_STATS; s++) {
+    for (i = 0; i < DENSE_LEN; i++)
+      dst->dense[s][i] += src->dense[s][i];
+    for (i = 0; i < src->cap[s]; i++) {
+      if (src->sparse[s][i].nb > 0)
+        _count(dst, s, src->sparse[s][i].v, src->sparse[s][i].nb);
+    }
+    dst->total[s] += src->total[s];
+    mpz_add(dst->sum[s], dst->sum[s], src->sum[s]);
+    mpz_add(dst->sq[s], dst->sq[s], src->sq[s]);
+  }
+}
+
+/* --- Parallel sampling -------------------------------------------------- */
+
+typedef struct {
+  randdag_stats_t *stats;
+  randdag_t (*sample)(gmp_randstate_t, unsigned long, void *);
+  void *arg;
+  unsigned long count, first, step;
+} _job;
+
+static void *_run(void *arg) {
+  _job *job = arg;
+  unsigned long i;
+  gmp_randstate_t state;
+
+  gmp_randinit_default(state);
+  for (i = job->first; i < job->count; i += job->step) {
+    randdag_t g = job->sample(state, i, job->arg);
+    randdag_stats_add(job->stats, g);
+    randdag_free(g);
+  }
+  gmp_randclear(state);
+  return NULL;
+}
+
+void randdag_stats_sample(randdag_stats_t *stats,
+                          randdag_t (*sample)(gmp_randstate_t, unsigned long i,
+                                              void *arg),
+                          void *arg, unsigned long count, int threads) {
+  int t;
+  _job *jobs;
+  pthread_t *ids;
+
+  if (threads < 1)
+    threads = 1;
+  jobs = malloc(threads * sizeof(_job));
+  ids = malloc(threads * sizeof(pthread_t));
+
+  /* Thread t draws the graphs t, t + threads, t + 2 * threads, etc. */
+  for (t = 0; t < threads; t++) {
+    jobs[t].stats = (t == 0) ? stats : randdag_stats_alloc(stats->which);
+    jobs[t].sample = sample;
+    jobs[t].arg = arg;
+    jobs[t].count = count;
+    jobs[t].first = t;
+    jobs[t].step = threads;
+    if (t > 0)
+      pthread_create(&ids[t], NULL, _run, &jobs[t]);
+  }
+  _run(&jobs[0]);
+
+  for (t = 1; t < threads; t++) {
+    pthread_join(ids[t], NULL);
+    randdag_stats_merge(stats, jobs[t].stats);
+    randdag_stats_free(jobs[t].stats);
+  }
+  free(jobs);
+  free(ids);
+}
+
+/* --- Output ------------------------------------------------------------- */
+
+static int _cmp_entries(const void *a, const void *b) {
+  const unsigned long x = ((const _entry *)a)->v, y = ((const _entry *)b)->v;
+  return (x > y) - (x < y);
+}
+
+/* The histogram of the s-th statistic, as an array of its *len distinct
+ * values sorted in increasing order. */
+static _entry *_sorted(const randdag_stats_t *stats, int s,
+                       unsigned long *len) {
+  unsigned long i, l = 0;
+  _entry *hist = malloc((DENSE_LEN + stats->used[s] + 1) * sizeof(_entry));
+
+  for (i = 0; i < DENSE_LEN; i++) {
+    if (stats->dense[s][i] > 0) {
+      hist[l].v = i;
+      hist[l++].nb = stats->dense[s][i];
+    }
+  }
+  for (i = 0; i < stats->cap[s]; i++) {
+    if (stats->sparse[s][i].nb > 0)
+      hist[l++] = stats->sparse[s][i];
+  }
+  /* The dense part is already sorted and below the sparse one. */
+  qsort(hist + (l - stats->used[s]), stats->used[s], sizeof(_entry),
+        _cmp_entries);
+  *len = l;
+  return hist;
+}
+
+/* Smallest value v such that at least a fraction p of the values are <= v. */
+static unsigned long _percentile(const _entry *hist, unsigned long len,
+                                 unsigned long total, double p) {
+  unsigned long i, cumul = 0;
+  const double rank = p * total;
+
+  for (i = 0; i + 1 < len; i++) {
+    cumul += hist[i].nb;
+    if (cumul > 0 && cumul >= rank)
+      break;
+  }
+  return len > 0 ? hist[i].v : 0;
+}
+
+void randdag_stats_print(FILE *fd, const randdag_stats_t *stats,
+                         int histograms) {
+  int s;
+  unsigned long i;
+  static const double quantiles[5] = {0.05, 0.25, 0.5, 0.75, 0.95};
+  mpz_t var;
+
+  fprintf(fd, "%-15s %10s %12s %12s %6s %6s %6s %6s %6s %6s %6s\n",
+          "statistic", "count", "mean", "stddev", "min", "p5", "p25", "p50",
+          "p75", "p95", "max");
+
+  mpz_init(var);
+  for (s = 0; s < NB_STATS; s++) {
+    const unsigned long total = stats->total[s];
+    double mean = 0, stddev = 0;
+    unsigned long len;
+    _entry *hist;
+    int q;
+
+    if (!(stats->which & (1u << s)))
+      continue;
+
+    /* The sample variance is (total * sq - sum^2) / (total * (total - 1)),
+     * whose numerator is computed exactly. */
+    if (total > 0)
+      mean = mpz_get_d(stats->sum[s]) / total;
+    if (total > 1) {
+      mpz_mul_ui(var, stats->sq[s], total);
+      mpz_submul(var, stats->sum[s], stats->sum[s]);
+      stddev = sqrt(mpz_get_d(var) / total / (total - 1));
+    }
+
+    hist = _sorted(stats, s, &len);
+    fprintf(fd, "%-15s %10lu %12.4f %12.4f %6lu", _names[s], total, mean,
+            stddev, len > 0 ? hist[0].v : 0);
+    for (q = 0; q < 5; q++)
+      fprintf(fd, " %6lu", _percentile(hist, len, total, quantiles[q]));
+    fprintf(fd, " %6lu\n", len > 0 ? hist[len - 1].v : 0);
+    free(hist);
+  }
+  mpz_clear(var);
+
+  if (!histograms)
+    return;
+  for (s = 0; s < NB_STATS; s++) {
+    unsigned long len;
+    _entry *hist;
+
+    if (!(stats->which & (1u << s)))
+      continue;
+    fprintf(fd, "\nhistogram of %s:\n", _names[s]);
+    hist = _sorted(stats, s, &len);
+    for (i = 0; i < len; i++)
+      fprintf(fd, "%6lu %10lu\n", hist[i].v, hist[i].nb);
+    free(hist);
+  }
+}
@@ -0,0 +1,112 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#include <malloc.h> /* calloc, realloc, free */
+
+#include <gmp.h>
+
+#include "../../includes/common.h"
+
+#define max(x, y) (((x) < (y)) ? (y) : (x))
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+window_t window_alloc(memo_t memo, randdag_counter_t count, int n_lo, int n_hi,
+                      int m_lo, int m_hi, int k_lo, int k_hi, int bound) {
+  int n, m, k, capacity;
+  window_t w;
+  mpz_t sum;
+
+  w.len = 0;
+  w.bound = bound;
+  capacity = 16;
+  w.n = malloc(capacity * sizeof(int));
+  w.m = malloc(capacity * sizeof(int));
+  w.k = malloc(capacity * sizeof(int));
+  w.cumul = malloc(capacity * sizeof(mpz_t));
+  mpz_init(sum);
+
+  for (n = max(n_lo, 0); n <= n_hi; n++) {
+    const int k_max = k_hi < 0 ? n : min(k_hi, n);
+    for (k = max(k_lo, n > 0); k <= k_max; k++) {
+      /* See _doag_count for the range of valid values of m. */
+      const int C = min(n - k, bound < 0 ? n : bound);
+      const int max_m = C * (C - 1) / 2 + (n - C) * C;
+      const int m_max = m_hi < 0 ? max_m : min(m_hi, max_m);
+      for (m = max(m_lo, n - k); m <= m_max; m++) {
+        mpz_t *x = count(memo, n, m, k, bound);
+        if (mpz_sgn(*x) == 0)
+          continue;
+
+        if (w.len == capacity) {
+          capacity = capacity * 2;
+          w.n = realloc(w.n, capacity * sizeof(int));
+          w.m = realloc(w.m, capacity * sizeof(int));
+          w.k = realloc(w.k, capacity * sizeof(int));
+          w.cumul = realloc(w.cumul, capacity * sizeof(mpz_t));
+        }
+        mpz_add(sum, sum, *x);
+        w.n[w.len] = n;
+        w.m[w.len] = m;
+        w.k[w.len] = k;
+        mpz_init_set(w.cumul[w.len], sum);
+        w.len++;
+      }
+    }
+  }
+
+  mpz_clear(sum);
+  return w;
+}
+
+void window_free(window_t w) {
+  int i;
+  for (i = 0; i < w.len; i++)
+    mpz_clear(w.cumul[i]);
+  free(w.n);
+  free(w.m);
+  free(w.k);
+  free(w.cumul);
+}
+
+int window_select(gmp_randstate_t state, const window_t w, int *n, int *m,
+                  int *k) {
+  int lo, hi;
+  mpz_t rank;
+
+  if (w.len == 0)
+    return 1;
+
+  mpz_init(rank);
+  mpz_urandomm(rank, state, w.cumul[w.len - 1]);
+
+  /* Binary search for the first i such that rank < cumul[i]. */
+  lo = 0;
+  hi = w.len - 1;
+  while (lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if (mpz_cmp(rank, w.cumul[mid]) < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  mpz_clear(rank);
+
+  *n = w.n[lo];
+  *m = w.m[lo];
+  *k = w.k[lo];
+  return 0;
+}
@@ -0,0 +1,112 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#include <malloc.h> /* malloc, realloc, free */
+#include <string.h> /* memcpy */
+
+#include "writer.h"
+
+void writer_init(writer_t *w, FILE *fd) {
+  w->fd = fd;
+  w->buf = malloc(WRITER_BUFSIZE);
+  w->len = 0;
+  w->cap = WRITER_BUFSIZE;
+  w->error = 0;
+}
+
+void writer_init_mem(writer_t *w) {
+  writer_init(w, NULL);
+}
+
+int writer_close(writer_t *w) {
+  writer_flush(w);
+  free(w->buf);
+  w->buf = NULL;
+  return w->error ? -1 : 0;
+}
+
+void writer_flush(writer_t *w) {
+  if (w->fd == NULL)
+    return;
+  if (w->len > 0 && fwrite(w->buf, 1, w->len, w->fd) != w->len)
+    w->error = 1;
+  w->len = 0;
+}
+
+void writer_make_room(writer_t *w, size_t nb) {
+  if (w->fd != NULL) {
+    writer_flush(w);
+  } else if (w->len + nb > w->cap) {
+    while (w->len + nb > w->cap)
+      w->cap *= 2;
+    w->buf = realloc(w->buf, w->cap);
+  }
+}
+
+void writer_bytes(writer_t *w, const char *bytes, size_t len) {
+  if (len > WRITER_BUFSIZE && w->fd != NULL) {
+    writer_flush(w);
+    if (fwrite(bytes, 1, len, w->fd) != len)
+      w->error = 1;
+    return;
+  }
+  writer_reserve(w, len);
+  memcpy(w->buf + w->len, bytes, len);
+  w->len += len;
+}
+
+void writer_uint(writer_t *w, unsigned long x) {
+  /* Enough for 64-bit integers. */
+  char digits[20];
+  int i = 20;
+
+  do {
+    digits[--i] = '0' + (char)(x % 10);
+    x /= 10;
+  } while (x > 0);
+
+  writer_reserve(w, 20);
+  memcpy(w->buf + w->len, digits + i, 20 - i);
+  w->len += 20 - i;
+}
+
+void writer_int(writer_t *w, long x) {
+  if (x < 0) {
+    writer_char(w, '-');
+    writer_uint(w, -(unsigned long)x);
+  } else {
+    writer_uint(w, x);
+  }
+}
+
+void writer_u32(writer_t *w, unsigned long x) {
+  char *c;
+
+  writer_reserve(w, 4);
+  c = w->buf + w->len;
+  c[0] = (char)(x & 0xff);
+  c[1] = (char)((x >> 8) & 0xff);
+  c[2] = (char)((x >> 16) & 0xff);
+  c[3] = (char)((x >> 24) & 0xff);
+  w->len += 4;
+}
+
+void writer_u64(writer_t *w, unsigned long x) {
+  /* Split the shift in two so that it is also defined for 32-bit longs. */
+  writer_u32(w, x & 0xffffffffUL);
+  writer_u32(w, (x >> 16) >> 16);
+}
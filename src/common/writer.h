@@ -0,0 +1,92 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef _RANDDAG_WRITER_H
+#define _RANDDAG_WRITER_H
+
+/* Buffered output for the graph writers.
+ *
+ * The output is accumulated in a large user-space buffer which is handed to
+ * fwrite only when full, and integers are formatted by hand rather than with
+ * printf, so that writing a graph costs a few instructions per byte.
+ * A writer can also target memory only, in which case its buffer grows as
+ * needed and is never flushed. */
+
+#include <stddef.h> /* size_t */
+#include <stdio.h>  /* FILE */
+
+#include "../../includes/common.h" /* randdag_t */
+
+#define WRITER_BUFSIZE (1 << 20)
+
+typedef struct {
+  /* NULL for in-memory writers. */
+  FILE *fd;
+  char *buf;
+  size_t len, cap;
+  /* Non-zero iff a write to fd has failed. */
+  int error;
+} writer_t;
+
+/* Start writing to fd. */
+void writer_init(writer_t *, FILE *fd);
+
+/* Start writing to memory. The output is available in buf[0..len[ and can be
+ * discarded by resetting len to zero. */
+void writer_init_mem(writer_t *);
+
+/* Flush the buffer and release it. Return 0 on success and -1 if any write
+ * failed. Note that fd is neither flushed nor closed. */
+int writer_close(writer_t *);
+
+/* Hand the content of the buffer to fwrite. */
+void writer_flush(writer_t *);
+
+/* Make room for nb bytes: flush the buffer, or grow it for in-memory
+ * writers. */
+void writer_make_room(writer_t *, size_t nb);
+
+/* Ensure that at least nb bytes are available in the buffer. */
+#define writer_reserve(w, nb)                                                  \
+  do {                                                                         \
+    if ((w)->len + (nb) > (w)->cap)                                            \
+      writer_make_room(w, nb);                                                 \
+  } while (0)
+
+/* Append raw bytes. */
+void writer_bytes(writer_t *, const char *bytes, size_t len);
+
+/* Append a single character. */
+#define writer_char(w, c)                                                      \
+  do {                                                                         \
+    writer_reserve(w, 1);                                                      \
+    (w)->buf[(w)->len++] = (c);                                                \
+  } while (0)
+
+/* Append the decimal representation of an integer. */
+void writer_uint(writer_t *, unsigned long);
+void writer_int(writer_t *, long);
+
+/* Append an integer in little-endian binary over 4 (resp. 8) bytes. */
+void writer_u32(writer_t *, unsigned long);
+void writer_u64(writer_t *, unsigned long);
+
+/* Write a graph in one of the formats of randdag_write (see graphs.c). */
+void randdag_write_w(writer_t *, const randdag_t, int format,
+                     unsigned int flags);
+
+#endif
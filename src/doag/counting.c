@@ -22,10 +22,79 @@
 #include <assert.h>
 
 #include "../../includes/doag.h"
+#include "small.h"
 
 #define min(x, y) (((x) < (y)) ? (x) : (y))
 #define IMPLIES(A, B) (!(A)) || (B)
 
+/* --- Machine-integer fast path ------------------------------------------ */
+
+/* Largest n such that no value handled by the recursive method (counts, sums
+ * of counts over k and m, and intermediate products) overflows a small_t, for
+ * each bound. The last entry holds for all larger bounds, including the
+ * unbounded case. For bound 0 all the counts are 1. */
+#if SMALL_BITS == 128
+static const int doag_thresholds[] = {64, 42, 23, 17, 15, 13, 12, 12, 12, 11};
+#elif SMALL_BITS == 64
+static const int doag_thresholds[] = {64, 25, 14, 11, 10, 9};
+#else
+static const int doag_thresholds[] = {1};
+#endif
+
+int doag_small_threshold(int bound) {
+  return small_threshold(doag_thresholds,
+                         sizeof(doag_thresholds) / sizeof(int), bound);
+}
+
+int doag_small_N(memo_t memo) {
+  return small_table_N(memo, doag_small_threshold(memo.bound));
+}
+
+/* Same as _doag_count with machine integers. */
+static small_t _doag_count_small(small_table *table, int n, int m, int k,
+                                 int bound) {
+  const int C = min(bound, n - k);
+
+  if (n <= 1) {
+    return 1;
+  } else {
+    int p, i;
+    small_t factor, *res = small_get_ptr(table, n, m, k);
+
+    if (*res != 0)
+      return *res;
+
+    for (p = 0; p <= min(C, m); p++) {
+      factor = 1;
+      for (i = 0; i <= min(p - (k == 1), m - n + k); i++) {
+        const int C2 = min(n - k - (p - i), bound);
+        if (m - p <= (C2 * (C2 - 1)) / 2 + C2 * (n - 1 - C2)) {
+          *res += _doag_count_small(table, n - 1, m - p, k - 1 + p - i, bound) *
+                  factor;
+        }
+        factor = factor * ((n - k - p + i + 1) * (p - i)) / (i + 1);
+      }
+    }
+
+    assert(*res > 0);
+    return *res;
+  }
+}
+
+small_t doag_count_small(memo_t memo, int n, int m, int k, int bound) {
+  const int C = min(bound, n - k);
+
+  assert(n <= doag_small_N(memo));
+  if ((n < 0) || ((n > 0) > k) || (k > n) || (n - k > m) ||
+      (m > C * (C - 1) / 2 + (n - C) * C)) {
+    return 0;
+  }
+
+  return _doag_count_small(memo.small, n, m, k, bound);
+}
+
+/* --- Counting DOAGs with n vertices, m edges and k sources -------------- */
+
 static mpz_t *_doag_count(memo_t memo, int n, int m, int k, int bound) {
   const int C = min(bound, n - k);
 
@@ -57,6 +126,12 @@ static mpz_t *_doag_count(memo_t memo, int n, int m, int k, int bound) {
     if (mpz_sgn(*res) != 0)
       return res;
 
+    /* Small values of n: compute with machine integers. */
+    if (n <= ((small_table *)memo.small)->N) {
+      small_get_mpz(*res, _doag_count_small(memo.small, n, m, k, bound));
+      return res;
+    }
+
     mpz_init(factor);
 
     /* For the invariant to hold recursively, we must have:
@@ -107,5 +182,73 @@ mpz_t *doag_count(memo_t memo, int n, int m, int k, int bound) {
     return memo.zero;
   }
 
+  /* Allocate the small table if needed. */
+  doag_small_N(memo);
   return _doag_count(memo, n, m, k, bound);
 }
+
+/* --- Counting DOAGs with n vertices and k sources, any number of edges -- */
+
+/* The factors of the recurrence used in _doag_count do not depend on m. Summing
+ * it over all the possible numbers of edges thus yields a recurrence on the
+ * (n, k) parameters alone, which is what we implement here.
+ * The table is filled one layer at a time, in increasing order of n, so that
+ * this also works for very large values of n without blowing up the stack. */
+
+static mpz_t *_doag_count_nk_get(memo_nk_t memo, int n, int k) {
+  if (n <= 1)
+    return (k == n) ? memo.one : memo.zero;
+  return memo_nk_get_ptr(memo, n, k);
+}
+
+/* Fill the n-th layer of the table assuming that the previous one is complete.
+ */
+static void _doag_count_nk_layer(memo_nk_t memo, int n, int bound) {
+  int k, p, i;
+  mpz_t factor;
+
+  mpz_init(factor);
+
+  for (k = 1; k <= n; k++) {
+    const int C = min(bound, n - k);
+    mpz_t *res = memo_nk_get_ptr(memo, n, k);
+
+    /* Same loop as in _doag_count where the conditions on m are dropped. */
+    for (p = 0; p <= C; p++) {
+      mpz_set_ui(factor, 1);
+      for (i = 0; i <= p - (k == 1); i++) {
+        /* Loop invariant: factor = binom(n-k-p+i,i) * p! / (p-i)! */
+        mpz_addmul(*res, *_doag_count_nk_get(memo, n - 1, k - 1 + p - i),
+                   factor);
+        mpz_mul_ui(factor, factor, (n - k - p + i + 1) * (p - i));
+        mpz_divexact_ui(factor, factor, i + 1);
+      }
+    }
+  }
+
+  mpz_clear(factor);
+}
+
+mpz_t *doag_count_nk(memo_nk_t memo, int n, int k, int bound) {
+  int l;
+
+  if (bound < 0)
+    bound = memo.bound;
+
+  if ((n < 0) || ((n > 0) > k) || (k > n))
+    return memo.zero;
+  if (n <= 1)
+    return memo.one;
+
+  /* The n-th layer is complete iff its last cell, which counts the graph with
+   * no edges, is non-zero. Look for the first incomplete layer. */
+  for (l = n; l >= 2; l--) {
+    if (mpz_sgn(*memo_nk_get_ptr(memo, l, l)) != 0)
+      break;
+  }
+  for (l = l + 1; l <= n; l++) {
+    _doag_count_nk_layer(memo, l, bound);
+  }
+
+  return memo_nk_get_ptr(memo, n, k);
+}
@@ -2,20 +2,35 @@
 $(BUILD)doag/doag: src/doag/cli.c
 $(BUILD)doag/doag: $(BUILD)libdoag.a
 $(BUILD)doag/doag: $(BUILD)common/cli.o
+$(BUILD)doag/doag: $(BUILD)common/server.o
+$(BUILD)doag/doag: $(BUILD)common/progress.o
 $(BUILD)doag/doag: $(BUILD)argtable.o
-	$(CC) $(CFLAGS) -L$(BUILD) -o $@ src/doag/cli.c $(BUILD)common/cli.o $(BUILD)argtable.o -ldoag -lgmp
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ src/doag/cli.c $(BUILD)common/cli.o $(BUILD)common/server.o $(BUILD)common/progress.o $(BUILD)argtable.o -ldoag -lgmp -lm -lpthread
 
 # Static library
 $(BUILD)libdoag.a: $(BUILD)common/graphs.o
 $(BUILD)libdoag.a: $(BUILD)common/memo.o
+$(BUILD)libdoag.a: $(BUILD)common/window.o
+$(BUILD)libdoag.a: $(BUILD)common/rng.o
+$(BUILD)libdoag.a: $(BUILD)common/small.o
+$(BUILD)libdoag.a: $(BUILD)common/writer.o
+$(BUILD)libdoag.a: $(BUILD)common/memo_z.o
+$(BUILD)libdoag.a: $(BUILD)common/memo_cache.o
+$(BUILD)libdoag.a: $(BUILD)common/memo_plan.o
+$(BUILD)libdoag.a: $(BUILD)common/lz.o
+$(BUILD)libdoag.a: $(BUILD)common/memo_par.o
+$(BUILD)libdoag.a: $(BUILD)common/shards.o
+$(BUILD)libdoag.a: $(BUILD)common/reader.o
+$(BUILD)libdoag.a: $(BUILD)common/mapbuf.o
+$(BUILD)libdoag.a: $(BUILD)common/stats.o
 $(BUILD)libdoag.a: $(BUILD)doag/counting.o
 $(BUILD)libdoag.a: $(BUILD)doag/sampling.o
 	$(AR) rc $@ $?
 	$(RANLIB) $@
 
-$(BUILD)doag/counting.o: src/doag/counting.c includes/doag.h
+$(BUILD)doag/counting.o: src/doag/counting.c src/doag/small.h includes/doag.h includes/common.h
 	@mkdir -p "$(BUILD)/doag"
 	$(CC) $(CFLAGS) -o $@ -c src/doag/counting.c
-$(BUILD)doag/sampling.o: src/doag/sampling.c includes/doag.h
+$(BUILD)doag/sampling.o: src/doag/sampling.c src/doag/small.h src/common/memo.h src/common/mapbuf.h includes/doag.h includes/common.h
 	@mkdir -p "$(BUILD)/doag"
 	$(CC) $(CFLAGS) -o $@ -c src/doag/sampling.c
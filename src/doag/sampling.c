@@ -18,9 +18,13 @@
 #include <assert.h>
 #include <gmp.h>
 #include <malloc.h>
+#include <string.h> /* memcpy */
 
 #include "../../includes/common.h"
 #include "../../includes/doag.h"
+#include "../common/mapbuf.h"
+#include "../common/memo.h"
+#include "small.h"
 
 #define min(x, y) (((x) < (y)) ? (x) : (y))
 
@@ -59,6 +63,50 @@ static void _add_src(gmp_randstate_t state, randdag_vertex *dest,
   }
 }
 
+/* Same as _doag_unif below, with machine integers, for n <= doag_small_N(memo).
+ */
+static void _doag_unif_small(gmp_randstate_t state, const memo_t memo,
+                             randdag_vertex *v, int n, int m, int k,
+                             int bound) {
+  small_t rank, factor, count;
+  int p, i;
+  const int C = min(bound, n - k);
+
+  if (n == 0)
+    return;
+
+  v[0].id = n;
+  if (n == 1) {
+    v[0].out_degree = 0;
+    v[0].out_edges = NULL;
+    return;
+  }
+
+  rank = small_urandomm(state, doag_count_small(memo, n, m, k, bound));
+
+  for (p = 0; p <= min(C, m); p++) {
+    factor = 1;
+    for (i = 0; i <= min(p - (k == 1), m - n + k); i++) {
+      const int C2 = min(n - k - (p - i), bound);
+      if (m - p <= (C2 * (C2 - 1)) / 2 + C2 * (n - 1 - C2)) {
+        count =
+            doag_count_small(memo, n - 1, m - p, k - 1 + p - i, bound) * factor;
+        if (rank < count) {
+          _doag_unif_small(state, memo, v + 1, n - 1, m - p, k - 1 + p - i,
+                           bound);
+          _add_src(state, v, v + k + p - i, n - k - p + i, i, p - i);
+          return;
+        }
+        rank -= count;
+      }
+      factor = factor * ((n - k - p + i + 1) * (p - i)) / (i + 1);
+    }
+  }
+
+  /* Reaching this point means that there is a bug in the algorithm. */
+  assert(0);
+}
+
 /* Core of the recursive method: uniform DOAG of parameters n, m, k */
 /* FIXME: this function wastes a lot of random bits, we should draw the rank
  * only once and do unranking. */
@@ -94,6 +142,12 @@ static void _doag_unif(gmp_randstate_t state, const memo_t memo,
     return;
   }
 
+  /* Small values of n: switch to machine integers. */
+  if (n <= ((small_table *)memo.small)->N) {
+    _doag_unif_small(state, memo, v, n, m, k, bound);
+    return;
+  }
+
   /* Draw a uniform rank. */
   mpz_init(rank);
   mpz_init(factor);
@@ -231,6 +285,105 @@ randdag_t doag_unif_nk(gmp_randstate_t state, const memo_t memo, int n, int k,
   assert(0);
 }
 
+/* --- Recursive method: uniform DOAG with parameters in a window --------- */
+
+randdag_t doag_unif_window(gmp_randstate_t state, const memo_t memo,
+                           const window_t w) {
+  int n, m, k;
+
+  /* Sanity check: there should exist a DOAG in the window. */
+  if (window_select(state, w, &n, &m, &k) != 0) {
+    fprintf(stderr, "Invalid parameters, there is no DOAG in the window\n");
+    assert(0);
+  }
+
+  return doag_unif_nmk(state, memo, n, m, k, w.bound);
+}
+
+/* --- Compact method: uniform DOAG with n vertices and bounded degree ---- */
+
+/* Same decomposition as in _doag_unif, but where the number of edges is left
+ * free so that only counting information indexed by (n, k) is needed.
+ * The recursion is unrolled: the choices made for each source are recorded
+ * top-down and the graph is then built bottom-up. The order in which random
+ * bits are consumed is the same as in the recursive version. */
+randdag_t doag_unif_n_bounded(gmp_randstate_t state, const memo_nk_t memo,
+                              int n, int bound) {
+  int j, k, p, i;
+  int *ks, *ss, *qs;
+  mpz_t rank, factor;
+  randdag_t g = randdag_alloc(n);
+
+  if (bound < 0)
+    bound = memo.bound;
+  if (n == 0)
+    return g;
+
+  ks = calloc(n, sizeof(int));
+  ss = calloc(n, sizeof(int));
+  qs = calloc(n, sizeof(int));
+  mpz_init(rank);
+  mpz_init(factor);
+
+  /* 1. Select the number of sources. */
+  for (k = 1; k <= n; k++) {
+    mpz_add(factor, factor, *doag_count_nk(memo, n, k, bound));
+  }
+  mpz_urandomm(rank, state, factor);
+  for (k = 1; k <= n; k++) {
+    mpz_sub(rank, rank, *doag_count_nk(memo, n, k, bound));
+    if (mpz_sgn(rank) < 0)
+      break;
+  }
+  assert(k <= n);
+
+  /* 2. Select the out-edges of each source, from the largest graph to the
+   * smallest. The j-th step removes the source of the graph of size n - j. */
+  ks[0] = k;
+  for (j = 0; j < n - 1; j++) {
+    const int nj = n - j;
+    const int kj = ks[j];
+    const int C = min(bound, nj - kj);
+
+    mpz_urandomm(rank, state, *doag_count_nk(memo, nj, kj, bound));
+    for (p = 0; p <= C; p++) {
+      mpz_set_ui(factor, 1);
+      for (i = 0; i <= p - (kj == 1); i++) {
+        mpz_submul(rank, *doag_count_nk(memo, nj - 1, kj - 1 + p - i, bound),
+                   factor);
+        if (mpz_sgn(rank) < 0)
+          goto found;
+        mpz_mul_ui(factor, factor, (nj - kj - p + i + 1) * (p - i));
+        mpz_divexact_ui(factor, factor, i + 1);
+      }
+    }
+    /* Reaching this point means that there is a bug in the algorithm. */
+    assert(0);
+
+  found:
+    ks[j + 1] = kj - 1 + p - i;
+    ss[j] = i;
+    qs[j] = p - i;
+  }
+  mpz_clear(rank);
+  mpz_clear(factor);
+
+  /* 3. Build the graph bottom-up. */
+  g.v[n - 1].id = 1;
+  g.v[n - 1].out_degree = 0;
+  g.v[n - 1].out_edges = NULL;
+  for (j = n - 2; j >= 0; j--) {
+    const int k1 = ks[j + 1];
+    g.v[j].id = n - j;
+    _add_src(state, g.v + j, g.v + j + 1 + k1, n - j - 1 - k1, ss[j], qs[j]);
+  }
+
+  free(ks);
+  free(ss);
+  free(qs);
+  return g;
+}
+
 /* --- Fast rejection method: uniform DOAG with n vertices ---------------- */
 
 /** Bernoulli random variable of parameter 1/p!.
@@ -311,13 +464,24 @@ static void permut_shuffle(gmp_randstate_t state, randdag_vertex *v, int n,
 /** Simulate the generation of a uniform matrix of variations, but computes
  * just enough information to know it should be rejected or if it corresponds
  * to a valid labelled transition matrix of DOAG. */
-static int doag_unif_n_sim(gmp_randstate_t state, randdag_t *g, int n,
+static int doag_unif_n_sim(gmp_randstate_t state, int *degree, int n,
                            int *nb_zeros, int *nb_unknown, int *path) {
   int i, j, streak;
 
+  /* There is only one such matrix for n <= 2: no vertex, a single vertex, or
+   * a source pointing to the sink. */
+  if (n <= 2) {
+    for (i = 0; i < n; i++) {
+      degree[i] = n - 1 - i;
+      nb_zeros[i] = nb_unknown[i] = 0;
+      path[i] = i - 1;
+    }
+    return 1;
+  }
+
   /* Source of the graph */
   nb_zeros[0] = bounded_poisson(state, n - 2);
-  g->v[0].out_degree = n - 1 - nb_zeros[0];
+  degree[0] = n - 1 - nb_zeros[0];
   nb_unknown[0] = n - 2;
 
   path[0] = -1;
@@ -328,7 +492,7 @@ static int doag_unif_n_sim(gmp_randstate_t state, randdag_t *g, int n,
     i = j - 1;
     nb_zeros[i] = bounded_poisson(state, n - 1 - i);
     nb_unknown[i] = n - i - 1;
-    g->v[i].out_degree = n - 1 - i - nb_zeros[i];
+    degree[i] = n - 1 - i - nb_zeros[i];
 
     while (i >= 0) {
       if ((int)gmp_urandomm_ui(state, nb_unknown[i]) < nb_zeros[i]) {
@@ -357,7 +521,8 @@ static int doag_unif_n_sim(gmp_randstate_t state, randdag_t *g, int n,
     path[j] = i;
   }
 
-  g->v[n - 2].out_degree = 1;
+  degree[n - 2] = 1;
+  degree[n - 1] = 0;
   nb_zeros[n - 2] = 0;
   nb_unknown[n - 2] = 0;
   path[n - 1] = n - 2;
@@ -376,6 +541,9 @@ static void doag_unif_n_populate(gmp_randstate_t state, randdag_t *g, int n,
   int i, j, p, nb_src;
   randdag_vertex *cur;
 
+  if (n == 0)
+    return;
+
   /* The sink */
   g->v[n - 1].out_edges = NULL;
 
@@ -399,7 +567,7 @@ static void doag_unif_n_populate(gmp_randstate_t state, randdag_t *g, int n,
      * add pointers to them at the beginning of the current vertex.
      * Their positions will be updated later. */
     nb_src = 0;
-    while (path[j] == i) {
+    while (j < n && path[j] == i) {
       assert(j > i);
       *cur = g->v[j];
       assert(cur->id > i);
@@ -436,25 +604,198 @@ randdag_t doag_unif_n(gmp_randstate_t state, int n) {
   int *nb_zeros;
   int *nb_unknown;
   int *path;
+  int *degree;
   randdag_t g = randdag_alloc(n);
 
   nb_zeros = calloc(n, sizeof(int));
   nb_unknown = calloc(n, sizeof(int));
   path = calloc(n, sizeof(int));
+  degree = calloc(n, sizeof(int));
+
+  /* Repeat doag_unif_n_sim util it finds a valid transition matrix. */
+  while (!doag_unif_n_sim(state, degree, n, nb_zeros, nb_unknown, path)) {
+  }
+  free(nb_unknown);
 
   /* Prepare the graph */
   for (i = 0; i < n; i++) {
     g.v[i].id = i;
+    g.v[i].out_degree = degree[i];
   }
+  free(degree);
 
-  /* Repeat doag_unif_n_sim util it finds a valid transition matrix. */
-  while (!doag_unif_n_sim(state, &g, n, nb_zeros, nb_unknown, path)) {
+  doag_unif_n_populate(state, &g, n, nb_zeros, path);
+  free(nb_zeros);
+  free(path);
+
+  return g;
+}
+
+/* --- Uniform DOAGs of size n, written straight to a CSR file ------------ */
+
+/* The CSR producer below stores the targets as 4-byte little-endian integers
+ * in a region mapped onto the output file. */
+
+static unsigned long get_u32(const unsigned char *p) {
+  return (unsigned long)p[0] | (unsigned long)p[1] << 8 |
+         (unsigned long)p[2] << 16 | (unsigned long)p[3] << 24;
+}
+
+static void put_u32(unsigned char *p, unsigned long x) {
+  p[0] = (unsigned char)(x & 0xff);
+  p[1] = (unsigned char)((x >> 8) & 0xff);
+  p[2] = (unsigned char)((x >> 16) & 0xff);
+  p[3] = (unsigned char)((x >> 24) & 0xff);
+}
+
+static void put_u64(unsigned char *p, unsigned long x) {
+  put_u32(p, x & 0xffffffffUL);
+  put_u32(p + 4, (x >> 16) >> 16);
+}
+
+/** Same as permut_shuffle, on an array of 4-byte integers. */
+static void permut_shuffle_u32(gmp_randstate_t state, unsigned char *v, int n,
+                               int k) {
+  unsigned long tmp;
+  int r;
+
+  while (n > 0) {
+    tmp = get_u32(v + 4 * (n - 1));
+    r = gmp_urandomm_ui(state, n);
+    if (r < k) {
+      put_u32(v + 4 * (n - 1), get_u32(v + 4 * (k - 1)));
+      put_u32(v + 4 * (k - 1), tmp);
+      k--;
+    } else {
+      put_u32(v + 4 * (n - 1), get_u32(v + 4 * r));
+      put_u32(v + 4 * r, tmp);
+    }
+    n--;
+  }
+}
+
+/** Same as doag_unif_n_populate, writing the targets of the out-edges of
+ * vertex i (the ids being 0 to n-1) at offset[i] in the `targets` array of
+ * 4-byte integers. The random choices are the same. */
+static void doag_unif_n_populate_csr(gmp_randstate_t state,
+                                     unsigned char *targets,
+                                     const unsigned long *offset, int n,
+                                     int *nb_zeros, int *path) {
+  int i, j, p, nb_src;
+  unsigned char *row, *cur;
+
+  for (i = n - 2; i >= 0; i--) {
+    p = nb_zeros[i];
+    row = cur = targets + 4 * offset[i];
+
+    j = i + 1;
+    while (path[j] < i) {
+      j++;
+    }
+
+    nb_src = 0;
+    while (j < n && path[j] == i) {
+      put_u32(cur, j);
+      cur += 4;
+      j++;
+      nb_src++;
+    }
+
+    while (j < n) {
+      if (!p || (int)gmp_urandomm_ui(state, n - j) > p) {
+        put_u32(cur, j);
+        cur += 4;
+      } else {
+        p--;
+      }
+      j++;
+    }
+
+    permut_shuffle_u32(state, row, (int)(offset[i + 1] - offset[i]), nb_src);
+  }
+}
+
+int doag_unif_n_csr(gmp_randstate_t state, int n, const char *filename) {
+  int i, error;
+  int *nb_zeros, *nb_unknown, *path, *degree;
+  unsigned long *offset;
+  size_t size, header;
+  mapbuf_t out;
+
+  if (mapbuf_open(&out, filename) != 0)
+    return -1;
+
+  nb_zeros = calloc(n, sizeof(int));
+  nb_unknown = calloc(n, sizeof(int));
+  path = calloc(n, sizeof(int));
+  degree = calloc(n, sizeof(int));
+  offset = calloc(n + 1, sizeof(unsigned long));
+
+  while (!doag_unif_n_sim(state, degree, n, nb_zeros, nb_unknown, path)) {
   }
   free(nb_unknown);
 
-  doag_unif_n_populate(state, &g, n, nb_zeros, path);
+  /* The out-degrees are known at this point, and thus the offsets. */
+  for (i = 0; i < n; i++)
+    offset[i + 1] = offset[i] + degree[i];
+  free(degree);
+
+  /* Header and offsets, see randdag_write. */
+  header = 24 + 8 * ((size_t)n + 1);
+  size = header + 4 * (size_t)offset[n];
+  error = mapbuf_reserve(&out, header);
+  if (!error) {
+    memcpy(out.p, "RDCS", 4);
+    put_u32(out.p + 4, 1);
+    put_u64(out.p + 8, n);
+    put_u64(out.p + 16, offset[n]);
+    for (i = 0; i <= n; i++)
+      put_u64(out.p + 24 + 8 * i, offset[i]);
+    error = mapbuf_reserve(&out, size);
+  }
+  if (!error)
+    doag_unif_n_populate_csr(state, out.p + header, offset, n, nb_zeros, path);
+
+  error |= mapbuf_close(&out, error ? 0 : size);
   free(nb_zeros);
   free(path);
+  free(offset);
+  return error ? -1 : 0;
+}
 
-  return g;
+/* --- Choice of the engine ----------------------------------------------- */
+
+sampler_plan_t doag_plan(int n, int m, int k, int bound, unsigned long count,
+                         size_t max_bytes) {
+  const int small_N = doag_small_threshold(bound < 0 ? n : bound);
+  return sampler_plan("doag", small_N, 1, n, m, k, bound, count, max_bytes);
+}
+
+randdag_t doag_unif_engine(gmp_randstate_t state, memo_t memo, int engine,
+                           int n, int m, int k, int bound) {
+  randdag_t g;
+
+  if (engine == RD_ENGINE_REJECTION)
+    return doag_unif_n(state, n);
+
+  if (engine == RD_ENGINE_COMPACT) {
+    memo_nk_t memo_nk = memo_nk_alloc(n, bound);
+    g = doag_unif_n_bounded(state, memo_nk, n, bound);
+    memo_nk_free(memo_nk);
+    return g;
+  }
+
+  /* The recursive method, with or without machine integers. */
+  if (k >= 0) {
+    return m >= 0 ? doag_unif_nmk(state, memo, n, m, k, bound)
+                  : doag_unif_nk(state, memo, n, k, bound);
+  } else if (m >= 0) {
+    return doag_unif_nm(state, memo, n, m, bound);
+  } else {
+    /* Select the number of edges and sources from the marginal counts. */
+    window_t w = window_alloc(memo, doag_count, n, n, -1, -1, -1, -1, bound);
+    g = doag_unif_window(state, memo, w);
+    window_free(w);
+    return g;
+  }
 }
@@ -20,13 +20,7 @@
 #include "../../includes/ldag.h"
 #include "../common/cli.h"
 
-static randdag_t sampler(gmp_randstate_t state, memo_t memo, int n, int m,
-                         int bound) {
-  if (m >= 0)
-    return ldag_unif_nm(state, memo, n, m, bound);
-  return ldag_unif_n(state, memo, n, bound);
-}
-
 int main(int argc, char *argv[]) {
-  return run_cli(argc, argv, ldag_count, sampler, RD_DOT_LABELLED);
+  return run_cli(argc, argv, "ldag", ldag_count, ldag_unif_engine,
+                 ldag_plan, NULL, RD_DOT_LABELLED);
 }
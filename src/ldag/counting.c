@@ -21,11 +21,83 @@
 
 #include "../../includes/common.h"
 #include "../../includes/ldag.h"
+#include "small.h"
 
 #include <assert.h>
 
 #define min(x, y) (((x) < (y)) ? (x) : (y))
 
+/* --- Machine-integer fast path ------------------------------------------ */
+
+/* Largest n such that no value handled by the recursive method (counts, sums
+ * of counts over k and m, intermediate products, and the products by n of the
+ * last step) overflows a small_t, for each bound. The last entry holds for all
+ * larger bounds, including the unbounded case. */
+#if SMALL_BITS == 128
+static const int ldag_thresholds[] = {64, 27, 19, 16, 15, 15, 14};
+#elif SMALL_BITS == 64
+static const int ldag_thresholds[] = {64, 16, 12, 10};
+#else
+static const int ldag_thresholds[] = {1};
+#endif
+
+int ldag_small_threshold(int bound) {
+  return small_threshold(ldag_thresholds,
+                         sizeof(ldag_thresholds) / sizeof(int), bound);
+}
+
+int ldag_small_N(memo_t memo) {
+  return small_table_N(memo, ldag_small_threshold(memo.bound));
+}
+
+/* Same as _ldag_count with machine integers. */
+static small_t _ldag_count_small(small_table *table, int n, int m, int k,
+                                 int bound) {
+  const int C = min(bound, n - k);
+
+  if (n <= 1) {
+    return 1;
+  } else {
+    int p, i;
+    small_t factor = 1, factor0 = 1, *res = small_get_ptr(table, n, m, k);
+
+    if (*res != 0)
+      return *res;
+
+    for (p = 0; p <= min(C, m); p++) {
+      for (i = 0; i <= min(p - (k == 1), m - n + k); i++) {
+        const int C2 = min(n - k - (p - i), bound);
+        if (m - p <= (C2 * (C2 - 1)) / 2 + C2 * (n - 1 - C2)) {
+          *res += _ldag_count_small(table, n - 1, m - p, k - 1 + p - i, bound) *
+                  factor;
+        }
+        factor = factor * ((n - k - p + i + 1) * (p - i)) /
+                 ((i + 1) * (k - 1 + p - i));
+      }
+      factor0 = factor0 * (k + p) / (p + 1);
+      factor = factor0;
+    }
+    *res = *res * n / k;
+
+    assert(*res > 0);
+    return *res;
+  }
+}
+
+small_t ldag_count_small(memo_t memo, int n, int m, int k, int bound) {
+  const int C = min(bound, n - k);
+
+  assert(n <= ldag_small_N(memo));
+  if ((n < 0) || ((n > 0) > k) || (k > n) || (n - k > m) ||
+      (m > C * (C - 1) / 2 + (n - C) * C)) {
+    return 0;
+  }
+
+  return _ldag_count_small(memo.small, n, m, k, bound);
+}
+
+/* --- Counting DAGs with n vertices, m edges and k sources --------------- */
+
 static mpz_t *_ldag_count(memo_t memo, int n, int m, int k, int bound) {
   const int C = min(bound, n - k);
 
@@ -54,6 +126,12 @@ static mpz_t *_ldag_count(memo_t memo, int n, int m, int k, int bound) {
     if (mpz_sgn(*res) != 0)
       return res;
 
+    /* Small values of n: compute with machine integers. */
+    if (n <= ((small_table *)memo.small)->N) {
+      small_get_mpz(*res, _ldag_count_small(memo.small, n, m, k, bound));
+      return res;
+    }
+
     mpz_init_set_ui(factor, 1);
     mpz_init_set_ui(factor0, 1);
 
@@ -119,5 +197,79 @@ mpz_t *ldag_count(memo_t memo, int n, int m, int k, int bound) {
     return memo.zero;
   }
 
+  /* Allocate the small table if needed. */
+  ldag_small_N(memo);
   return _ldag_count(memo, n, m, k, bound);
 }
+
+/* --- Counting DAGs with n vertices and k sources, any number of edges --- */
+
+/* As for DOAGs, the factors of the recurrence used in _ldag_count do not depend
+ * on m, which gives a recurrence on (n, k) alone when summing over all the
+ * possible numbers of edges. The table is filled one layer at a time. */
+
+static mpz_t *_ldag_count_nk_get(memo_nk_t memo, int n, int k) {
+  if (n <= 1)
+    return (k == n) ? memo.one : memo.zero;
+  return memo_nk_get_ptr(memo, n, k);
+}
+
+/* Fill the n-th layer of the table assuming that the previous one is complete.
+ */
+static void _ldag_count_nk_layer(memo_nk_t memo, int n, int bound) {
+  int k, p, i;
+  mpz_t factor, factor0;
+
+  mpz_init(factor);
+  mpz_init(factor0);
+
+  for (k = 1; k <= n; k++) {
+    const int C = min(bound, n - k);
+    mpz_t *res = memo_nk_get_ptr(memo, n, k);
+
+    mpz_set_ui(factor, 1);
+    mpz_set_ui(factor0, 1);
+
+    /* Same loop as in _ldag_count where the conditions on m are dropped. */
+    for (p = 0; p <= C; p++) {
+      for (i = 0; i <= p - (k == 1); i++) {
+        mpz_addmul(*res, *_ldag_count_nk_get(memo, n - 1, k - 1 + p - i),
+                   factor);
+        mpz_mul_ui(factor, factor, (n - k - p + i + 1) * (p - i));
+        mpz_divexact_ui(factor, factor, (i + 1) * (k - 1 + p - i));
+      }
+      mpz_mul_ui(factor0, factor0, k + p);
+      mpz_divexact_ui(factor0, factor0, p + 1);
+      mpz_set(factor, factor0);
+    }
+    mpz_mul_ui(*res, *res, n);
+    mpz_divexact_ui(*res, *res, k);
+  }
+
+  mpz_clear(factor);
+  mpz_clear(factor0);
+}
+
+mpz_t *ldag_count_nk(memo_nk_t memo, int n, int k, int bound) {
+  int l;
+
+  if (bound < 0)
+    bound = memo.bound;
+
+  if ((n < 0) || ((n > 0) > k) || (k > n))
+    return memo.zero;
+  if (n <= 1)
+    return memo.one;
+
+  /* The n-th layer is complete iff its last cell, which counts the graph with
+   * no edges, is non-zero. Look for the first incomplete layer. */
+  for (l = n; l >= 2; l--) {
+    if (mpz_sgn(*memo_nk_get_ptr(memo, l, l)) != 0)
+      break;
+  }
+  for (l = l + 1; l <= n; l++) {
+    _ldag_count_nk_layer(memo, l, bound);
+  }
+
+  return memo_nk_get_ptr(memo, n, k);
+}
@@ -2,21 +2,35 @@
 $(BUILD)ldag/ldag: src/ldag/cli.c
 $(BUILD)ldag/ldag: $(BUILD)libldag.a
 $(BUILD)ldag/ldag: $(BUILD)common/cli.o
+$(BUILD)ldag/ldag: $(BUILD)common/server.o
+$(BUILD)ldag/ldag: $(BUILD)common/progress.o
 $(BUILD)ldag/ldag: $(BUILD)argtable.o
-	$(CC) $(CFLAGS) -L$(BUILD) -o $@ src/ldag/cli.c $(BUILD)common/cli.o $(BUILD)argtable.o -lldag -lgmp
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ src/ldag/cli.c $(BUILD)common/cli.o $(BUILD)common/server.o $(BUILD)common/progress.o $(BUILD)argtable.o -lldag -lgmp -lm -lpthread
 
 # Static library
 $(BUILD)libldag.a: $(BUILD)common/graphs.o
 $(BUILD)libldag.a: $(BUILD)common/memo.o
+$(BUILD)libldag.a: $(BUILD)common/window.o
+$(BUILD)libldag.a: $(BUILD)common/rng.o
+$(BUILD)libldag.a: $(BUILD)common/small.o
+$(BUILD)libldag.a: $(BUILD)common/writer.o
+$(BUILD)libldag.a: $(BUILD)common/memo_z.o
+$(BUILD)libldag.a: $(BUILD)common/memo_cache.o
+$(BUILD)libldag.a: $(BUILD)common/memo_plan.o
+$(BUILD)libldag.a: $(BUILD)common/lz.o
+$(BUILD)libldag.a: $(BUILD)common/memo_par.o
+$(BUILD)libldag.a: $(BUILD)common/shards.o
+$(BUILD)libldag.a: $(BUILD)common/reader.o
+$(BUILD)libldag.a: $(BUILD)common/stats.o
 $(BUILD)libldag.a: $(BUILD)ldag/counting.o
 $(BUILD)libldag.a: $(BUILD)ldag/sampling.o
 	$(AR) rc $@ $?
 	$(RANLIB) $@
 
-$(BUILD)ldag/counting.o: src/ldag/counting.c includes/ldag.h
+$(BUILD)ldag/counting.o: src/ldag/counting.c src/ldag/small.h includes/ldag.h includes/common.h
 	@mkdir -p "$(BUILD)ldag"
 	$(CC) $(CFLAGS) -o $@ -c src/ldag/counting.c
 
-$(BUILD)ldag/sampling.o: src/ldag/sampling.c includes/ldag.h
+$(BUILD)ldag/sampling.o: src/ldag/sampling.c src/ldag/small.h src/common/memo.h includes/ldag.h includes/common.h
 	@mkdir -p "$(BUILD)ldag"
 	$(CC) $(CFLAGS) -o $@ -c src/ldag/sampling.c
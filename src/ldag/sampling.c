@@ -22,6 +22,8 @@
 
 #include "../../includes/common.h"
 #include "../../includes/ldag.h"
+#include "../common/memo.h"
+#include "small.h"
 
 #define min(x, y) (((x) < (y)) ? (x) : (y))
 
@@ -68,6 +70,54 @@ static void _add_src(gmp_randstate_t state, randdag_vertex *dest,
   }
 }
 
+/* Same as _ldag_unif below, with machine integers, for n <= ldag_small_N(memo).
+ */
+static void _ldag_unif_small(gmp_randstate_t state, const memo_t memo,
+                             const int *labels, randdag_vertex *v, int n,
+                             int m, int k, int bound) {
+  small_t rank, factor = 1, factor0 = 1, count;
+  int p, i;
+  const int C = min(bound, n - k);
+
+  if (n == 0)
+    return;
+
+  v[0].id = labels[0];
+  if (n == 1) {
+    v[0].out_degree = 0;
+    v[0].out_edges = NULL;
+    return;
+  }
+
+  rank = small_urandomm(state, ldag_count_small(memo, n, m, k, bound) * k / n);
+
+  for (p = 0; p <= min(C, m); p++) {
+    for (i = 0; i <= min(p - (k == 1), m - n + k); i++) {
+      const int C2 = min(n - k - (p - i), bound);
+
+      if (m - p <= (C2 * (C2 - 1)) / 2 + C2 * (n - 1 - C2)) {
+        count =
+            ldag_count_small(memo, n - 1, m - p, k - 1 + p - i, bound) * factor;
+        if (rank < count) {
+          _ldag_unif_small(state, memo, labels + 1, v + 1, n - 1, m - p,
+                           k - 1 + p - i, bound);
+          _add_src(state, v, v + k + p - i, k - 1 + p - i, n - k - p + i, i,
+                   p - i);
+          return;
+        }
+        rank -= count;
+      }
+      factor = factor * ((n - k - p + i + 1) * (p - i)) /
+               ((i + 1) * (k - 1 + p - i));
+    }
+    factor0 = factor0 * (k + p) / (p + 1);
+    factor = factor0;
+  }
+
+  /* Reaching this point means that there is a bug in the algorithm. */
+  assert(0);
+}
+
 static void _ldag_unif(gmp_randstate_t state, const memo_t memo,
                        const int *labels, randdag_vertex *v, int n, int m,
                        int k, int bound) {
@@ -101,6 +151,12 @@ static void _ldag_unif(gmp_randstate_t state, const memo_t memo,
     return;
   }
 
+  /* Small values of n: switch to machine integers. */
+  if (n <= ((small_table *)memo.small)->N) {
+    _ldag_unif_small(state, memo, labels, v, n, m, k, bound);
+    return;
+  }
+
   mpz_init(rank);
   mpz_init_set_ui(factor, 1);
   mpz_init_set_ui(factor0, 1);
@@ -310,3 +366,142 @@ randdag_t ldag_unif_n(gmp_randstate_t state, const memo_t memo, int n,
   /* Reaching this point means there is a bug in the selection algorithm. */
   assert(0);
 }
+
+/* --- Recursive method: uniform DAG with parameters in a window ---------- */
+
+randdag_t ldag_unif_window(gmp_randstate_t state, const memo_t memo,
+                           const window_t w) {
+  int n, m, k;
+
+  /* Sanity check: there should exist a DAG in the window. */
+  if (window_select(state, w, &n, &m, &k) != 0) {
+    fprintf(stderr, "Invalid parameters, there is no DAG in the window\n");
+    assert(0);
+  }
+
+  return ldag_unif_nmk(state, memo, n, m, k, w.bound);
+}
+
+/* --- Compact method: uniform DAG with n vertices and bounded degree ----- */
+
+/* Same decomposition as in _ldag_unif, but where the number of edges is left
+ * free so that only counting information indexed by (n, k) is needed.
+ * The recursion is unrolled: the choices made for each source are recorded
+ * top-down and the graph is then built bottom-up. The order in which random
+ * bits are consumed is the same as in the recursive version. */
+randdag_t ldag_unif_n_bounded(gmp_randstate_t state, const memo_nk_t memo,
+                              int n, int bound) {
+  int j, k, p, i;
+  int *labels, *ks, *ss, *qs;
+  mpz_t rank, factor, factor0;
+  randdag_t g = randdag_alloc(n);
+
+  if (bound < 0)
+    bound = memo.bound;
+  if (n == 0)
+    return g;
+
+  ks = calloc(n, sizeof(int));
+  ss = calloc(n, sizeof(int));
+  qs = calloc(n, sizeof(int));
+  labels = calloc(n, sizeof(int));
+  mpz_init(rank);
+  mpz_init(factor);
+  mpz_init(factor0);
+
+  /* 1. Select the number of sources. */
+  for (k = 1; k <= n; k++) {
+    mpz_add(factor, factor, *ldag_count_nk(memo, n, k, bound));
+  }
+  mpz_urandomm(rank, state, factor);
+  for (k = 1; k <= n; k++) {
+    mpz_sub(rank, rank, *ldag_count_nk(memo, n, k, bound));
+    if (mpz_sgn(rank) < 0)
+      break;
+  }
+  assert(k <= n);
+  _fisher_yates(state, labels, n);
+
+  /* 2. Select the out-edges of each source, from the largest graph to the
+   * smallest. The j-th step removes the source of the graph of size n - j. */
+  ks[0] = k;
+  for (j = 0; j < n - 1; j++) {
+    const int nj = n - j;
+    const int kj = ks[j];
+    const int C = min(bound, nj - kj);
+
+    mpz_mul_ui(factor, *ldag_count_nk(memo, nj, kj, bound), kj);
+    mpz_divexact_ui(factor, factor, nj);
+    mpz_urandomm(rank, state, factor);
+
+    mpz_set_ui(factor, 1);
+    mpz_set_ui(factor0, 1);
+    for (p = 0; p <= C; p++) {
+      for (i = 0; i <= p - (kj == 1); i++) {
+        mpz_submul(rank, *ldag_count_nk(memo, nj - 1, kj - 1 + p - i, bound),
+                   factor);
+        if (mpz_sgn(rank) < 0)
+          goto found;
+        mpz_mul_ui(factor, factor, (nj - kj - p + i + 1) * (p - i));
+        mpz_divexact_ui(factor, factor, (i + 1) * (kj - 1 + p - i));
+      }
+      mpz_mul_ui(factor0, factor0, kj + p);
+      mpz_divexact_ui(factor0, factor0, p + 1);
+      mpz_set(factor, factor0);
+    }
+    /* Reaching this point means that there is a bug in the algorithm. */
+    assert(0);
+
+  found:
+    ks[j + 1] = kj - 1 + p - i;
+    ss[j] = i;
+    qs[j] = p - i;
+  }
+  mpz_clears(rank, factor, factor0, NULL);
+
+  /* 3. Build the graph bottom-up. */
+  g.v[n - 1].id = labels[n - 1];
+  g.v[n - 1].out_degree = 0;
+  g.v[n - 1].out_edges = NULL;
+  for (j = n - 2; j >= 0; j--) {
+    const int k1 = ks[j + 1];
+    g.v[j].id = labels[j];
+    _add_src(state, g.v + j, g.v + j + 1 + k1, k1, n - j - 1 - k1, ss[j],
+             qs[j]);
+  }
+
+  free(labels);
+  free(ks);
+  free(ss);
+  free(qs);
+  return g;
+}
+
+/* --- Choice of the engine ----------------------------------------------- */
+
+sampler_plan_t ldag_plan(int n, int m, int k, int bound, unsigned long count,
+                         size_t max_bytes) {
+  const int small_N = ldag_small_threshold(bound < 0 ? n : bound);
+  return sampler_plan("ldag", small_N, 0, n, m, k, bound, count, max_bytes);
+}
+
+randdag_t ldag_unif_engine(gmp_randstate_t state, memo_t memo, int engine,
+                           int n, int m, int k, int bound) {
+  randdag_t g;
+
+  if (engine == RD_ENGINE_COMPACT) {
+    memo_nk_t memo_nk = memo_nk_alloc(n, bound);
+    g = ldag_unif_n_bounded(state, memo_nk, n, bound);
+    memo_nk_free(memo_nk);
+    return g;
+  }
+
+  /* The recursive method, with or without machine integers. */
+  if (k >= 0) {
+    return m >= 0 ? ldag_unif_nmk(state, memo, n, m, k, bound)
+                  : ldag_unif_nk(state, memo, n, k, bound);
+  }
+  if (m >= 0)
+    return ldag_unif_nm(state, memo, n, m, bound);
+  return ldag_unif_n(state, memo, n, bound);
+}
@@ -0,0 +1,37 @@
+/* Randdag: C library for the uniform random generation of DAGs
+
+   Copyright (C) 2020  Martin Pépin, Antoine Genitrini and Alfredo Viola
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef _RANDDAG_LDAG_SMALL_H
+#define _RANDDAG_LDAG_SMALL_H
+
+/* Machine-integer fast path of the recursive method for labelled DAGs. Shared by
+ * counting.c and sampling.c. */
+
+#include "../../includes/common.h"
+#include "../common/small.h"
+
+/* Largest n for which the small table of a memo_t of this bound is used,
+ * unless the table has fewer layers. The bound must be non-negative. */
+int ldag_small_threshold(int bound);
+
+/* Largest n for which the small table of memo is used. */
+int ldag_small_N(memo_t memo);
+
+/* Same as ldag_count, restricted to n <= ldag_small_N(memo). */
+small_t ldag_count_small(memo_t memo, int n, int m, int k, int bound);
+
+#endif
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Check that doag_count_nk(n, k) is the sum over m of doag_count(n, m, k). */
+static int counts(int N, int bound) {
+  int n, m, k, error;
+  mpz_t sum;
+  memo_t memo = memo_alloc(N, -1, bound);
+  memo_nk_t memo_nk = memo_nk_alloc(N, bound);
+
+  mpz_init(sum);
+  error = 0;
+
+  for (n = 0; n <= N; n++) {
+    for (k = 0; k <= n; k++) {
+      const int C = min(n - k, bound < 0 ? n : bound);
+      mpz_set_ui(sum, 0);
+      for (m = n - k; m <= C * (C - 1) / 2 + C * (n - C); m++)
+        mpz_add(sum, sum, *doag_count(memo, n, m, k, bound));
+      if (mpz_cmp(sum, *doag_count_nk(memo_nk, n, k, bound)) != 0) {
+        fprintf(stderr, "[ERROR] doag_count_nk(<memo>, %d, %d, %d) returned ",
+                n, k, bound);
+        mpz_out_str(stderr, 10, *doag_count_nk(memo_nk, n, k, bound));
+        fprintf(stderr, " instead of ");
+        mpz_out_str(stderr, 10, sum);
+        fprintf(stderr, "\n");
+        error = 1;
+      }
+    }
+  }
+
+  mpz_clear(sum);
+  memo_free(memo);
+  memo_nk_free(memo_nk);
+  return error;
+}
+
+/* --- Empirical distribution of the samplers ---------------------------- */
+
+#define MAX_CLASSES 1024
+#define KEY_LEN 64
+
+typedef struct {
+  int nb;
+  char keys[MAX_CLASSES][KEY_LEN];
+  long hits[2][MAX_CLASSES];
+} histogram;
+
+/* Serialise a small graph into a string, vertices being sorted by id. Also
+ * check that the graph is acyclic and has bounded out-degree. */
+static int encode(const randdag_t g, int bound, char *key) {
+  int id, i, j;
+  char *c = key;
+
+  for (id = 1; id <= g.N; id++) {
+    for (i = 0; i < g.N && g.v[i].id != id; i++) {
+    }
+    if (i == g.N || (bound >= 0 && g.v[i].out_degree > bound))
+      return 1;
+    for (j = 0; j < g.v[i].out_degree; j++) {
+      if (g.v[i].out_edges[j].id >= id)
+        return 1;
+      *c++ = '0' + g.v[i].out_edges[j].id;
+    }
+    *c++ = ';';
+  }
+  *c = '\0';
+  return 0;
+}
+
+static int record(histogram *h, int which, const randdag_t g, int bound) {
+  int i;
+  char key[KEY_LEN];
+
+  if (encode(g, bound, key))
+    return 1;
+  for (i = 0; i < h->nb && strcmp(h->keys[i], key) != 0; i++) {
+  }
+  if (i == h->nb) {
+    if (h->nb == MAX_CLASSES)
+      return 1;
+    strcpy(h->keys[i], key);
+    h->nb++;
+  }
+  h->hits[which][i]++;
+  return 0;
+}
+
+/* Reference sampler: select (m, k) and call doag_unif_nmk. */
+static randdag_t reference(gmp_randstate_t state, memo_t memo, int n,
+                           int bound) {
+  int m, k;
+  mpz_t sum, rank;
+
+  mpz_init(sum);
+  mpz_init(rank);
+  for (k = 0; k <= n; k++) {
+    for (m = 0; m <= n * (n - 1) / 2; m++)
+      mpz_add(sum, sum, *doag_count(memo, n, m, k, bound));
+  }
+  mpz_urandomm(rank, state, sum);
+  for (k = 0; k <= n; k++) {
+    for (m = 0; m <= n * (n - 1) / 2; m++) {
+      mpz_sub(rank, rank, *doag_count(memo, n, m, k, bound));
+      if (mpz_sgn(rank) < 0)
+        goto found;
+    }
+  }
+found:
+  mpz_clears(sum, rank, NULL);
+  return doag_unif_nmk(state, memo, n, m, k, bound);
+}
+
+/* Compare the empirical distributions of doag_unif_n_bounded and of the
+ * reference sampler using the total variation distance. */
+static int distribution(int n, int bound, long nb_samples) {
+  long s;
+  int i, error;
+  double tv;
+  histogram *h = calloc(1, sizeof(histogram));
+  memo_t memo = memo_alloc(n, -1, bound);
+  memo_nk_t memo_nk = memo_nk_alloc(n, bound);
+  gmp_randstate_t state;
+
+  gmp_randinit_default(state);
+  gmp_randseed_ui(state, 0xdeadbeef);
+  error = 0;
+
+  for (s = 0; s < nb_samples && !error; s++) {
+    randdag_t g = doag_unif_n_bounded(state, memo_nk, n, bound);
+    error |= record(h, 0, g, bound);
+    randdag_free(g);
+    g = reference(state, memo, n, bound);
+    error |= record(h, 1, g, bound);
+    randdag_free(g);
+  }
+
+  if (error) {
+    fprintf(stderr, "[ERROR] doag_unif_n_bounded(<memo>, %d, %d) returned an "
+                    "invalid graph\n",
+            n, bound);
+  } else {
+    tv = 0.;
+    for (i = 0; i < h->nb; i++) {
+      const long d = h->hits[0][i] - h->hits[1][i];
+      tv += (d < 0 ? -d : d);
+    }
+    tv = tv / (2. * nb_samples);
+    if (tv > 0.04) {
+      fprintf(stderr,
+              "[ERROR] doag_unif_n_bounded(<memo>, %d, %d) is too far from "
+              "doag_unif_nmk: total variation distance = %f\n",
+              n, bound, tv);
+      error = 1;
+    }
+  }
+
+  gmp_randclear(state);
+  memo_free(memo);
+  memo_nk_free(memo_nk);
+  free(h);
+  return error;
+}
+
+int main() {
+  int error = 0;
+
+  error |= counts(12, 0);
+  error |= counts(12, 1);
+  error |= counts(12, 2);
+  error |= counts(12, 3);
+  error |= counts(10, -1);
+  /* Around the thresholds of the machine-integer fast path. */
+  error |= counts(24, 2);
+  error |= counts(18, 3);
+  error |= counts(16, -1);
+
+  error |= distribution(4, 1, 50000);
+  error |= distribution(4, 2, 50000);
+  error |= distribution(5, 1, 50000);
+
+  fprintf(stderr, "TEST bounded sampler: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
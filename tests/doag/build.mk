@@ -1,8 +1,19 @@
 # Run all the tests
 DOAG_TESTS = \
+	$(BUILD)tests/doag/bounded \
+	$(BUILD)tests/doag/cache \
+	$(BUILD)tests/doag/dump \
+	$(BUILD)tests/doag/engines \
 	$(BUILD)tests/doag/forests \
+	$(BUILD)tests/doag/formats \
+	$(BUILD)tests/doag/plan \
+	$(BUILD)tests/doag/reader \
+	$(BUILD)tests/doag/shards \
 	$(BUILD)tests/doag/small_cases \
+	$(BUILD)tests/doag/stats \
+	$(BUILD)tests/doag/streams \
 	$(BUILD)tests/doag/unary_binary \
+	$(BUILD)tests/doag/window \
 
 doag-tests: $(DOAG_TESTS)
 	for t in $(DOAG_TESTS); do ./$$t; done
@@ -13,12 +24,56 @@ doag-tests: $(DOAG_TESTS)
 
 $(BUILD)tests/doag/forests: tests/doag/forests.c $(BUILD)libdoag.a
 	@mkdir -p "$(BUILD)tests/doag"
-	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/forests.c -ldoag -lgmp
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/forests.c -ldoag -lgmp -lm -lpthread
 
 $(BUILD)tests/doag/unary_binary: tests/doag/unary_binary.c $(BUILD)libdoag.a
 	@mkdir -p "$(BUILD)tests/doag"
-	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/unary_binary.c -ldoag -lgmp
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/unary_binary.c -ldoag -lgmp -lm -lpthread
 
 $(BUILD)tests/doag/small_cases: tests/doag/small_cases.c $(BUILD)libdoag.a
 	@mkdir -p "$(BUILD)tests/doag"
-	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/small_cases.c -ldoag -lgmp
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/small_cases.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/bounded: tests/doag/bounded.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/bounded.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/window: tests/doag/window.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/window.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/streams: tests/doag/streams.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/streams.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/plan: tests/doag/plan.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/plan.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/engines: tests/doag/engines.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/engines.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/stats: tests/doag/stats.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/stats.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/formats: tests/doag/formats.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/formats.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/dump: tests/doag/dump.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/dump.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/shards: tests/doag/shards.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/shards.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/reader: tests/doag/reader.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/reader.c -ldoag -lgmp -lm -lpthread
+
+$(BUILD)tests/doag/cache: tests/doag/cache.c $(BUILD)libdoag.a
+	@mkdir -p "$(BUILD)tests/doag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/doag/cache.c -ldoag -lgmp -lm -lpthread
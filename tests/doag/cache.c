@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Get a table from the cache and compare it with a freshly computed one of the
+ * same shape. The status returned by memo_cache_get must be `expected`. */
+static int cached(const char *dir, int N, int M, int bound, int expected) {
+  int n, m, k, status, error;
+  memo_t memo, ref;
+
+  status = memo_cache_get(&memo, dir, "doag", doag_count, N, M, bound);
+  error = (status != expected) || memo.N != N;
+
+  /* The cached table may have room for more edges than requested. */
+  ref = memo_alloc(N, memo.M, bound);
+  for (n = 2; n <= N; n++)
+    memo_fill_layer(ref, doag_count, n);
+  for (n = 2; !error && n <= N; n++) {
+    for (k = 1; k <= n; k++) {
+      const int C = min(n - k, ref.bound);
+      const int max_m = min((C - 1) * C / 2 + C * (n - C), ref.M);
+      for (m = 0; m <= max_m; m++) {
+        error |= mpz_cmp(*memo_get_ptr(memo, n, m, k),
+                         *memo_get_ptr(ref, n, m, k)) != 0;
+      }
+    }
+  }
+
+  if (error) {
+    fprintf(stderr,
+            "[ERROR] cached table for N=%d, M=%d, bound=%d: status %d "
+            "instead of %d or wrong counts\n",
+            N, M, bound, status, expected);
+  }
+
+  memo_free(memo);
+  memo_free(ref);
+  return error;
+}
+
+int main(int argc, char *argv[]) {
+  int error = 0;
+  char dir[200], file[256];
+
+  /* Use a fresh cache next to the test executable. */
+  (void)argc;
+  sprintf(dir, "%.190s.cache", argv[0]);
+
+  /* Miss, then hits for smaller tables. */
+  error |= cached(dir, 20, -1, 3, 0);
+  error |= cached(dir, 15, -1, 3, 1);
+  error |= cached(dir, 20, 40, 3, 1);
+  /* The table is extended and replaced. */
+  error |= cached(dir, 25, -1, 3, 0);
+  error |= cached(dir, 20, -1, 3, 1);
+  /* Tables are per bound and number of edges. */
+  error |= cached(dir, 18, 30, -1, 0);
+  error |= cached(dir, 18, 20, -1, 1);
+  error |= cached(dir, 18, -1, -1, 0);
+  error |= cached(dir, 17, 30, -1, 1);
+
+  /* Only the largest tables are left. */
+  sprintf(file, "%s/doag-3-25-69.rdz", dir);
+  error |= remove(file) != 0;
+  sprintf(file, "%s/doag-18-18-153.rdz", dir);
+  error |= remove(file) != 0;
+  error |= remove(dir) != 0;
+
+  fprintf(stderr, "TEST memo cache: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Read the whole content of a file. */
+static char *content(FILE *fd, long *size) {
+  char *buf;
+  fseek(fd, 0, SEEK_END);
+  *size = ftell(fd);
+  buf = malloc(*size + 1);
+  rewind(fd);
+  if (fread(buf, 1, *size, fd) != (size_t)*size)
+    *size = -1;
+  return buf;
+}
+
+/* Compare all the cells of two tables of the same shape. */
+static int same_cells(memo_t a, memo_t b) {
+  int n, m, k;
+
+  for (n = 2; n <= a.N; n++) {
+    for (k = 1; k <= n; k++) {
+      const int C = min(n - k, a.bound);
+      const int max_m = min((C - 1) * C / 2 + C * (n - C), a.M);
+      for (m = 0; m <= max_m; m++) {
+        if (mpz_cmp(*memo_get_ptr(a, n, m, k), *memo_get_ptr(b, n, m, k)))
+          return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/* Fill a table for the DOAGs with n vertices and m edges, dump it in
+ * compressed form, load it back in a fresh table and compare. */
+static int roundtrip(int N, int n, int m, int bound) {
+  int error, k, N2, M2, bound2;
+  char model[MEMO_Z_MODEL_LEN + 1];
+  memo_z_stats stats;
+  memo_t memo = memo_alloc(N, -1, bound);
+  memo_t memo2 = memo_alloc(N, -1, bound);
+  FILE *fd = tmpfile();
+
+  for (k = 1; k <= n; k++)
+    doag_count(memo, n, m, k, bound);
+
+  error = memo_dump_z(fd, memo, "doag", &stats);
+  rewind(fd);
+  error |= memo_z_header(fd, model, &N2, &M2, &bound2);
+  error |= (strcmp(model, "doag") != 0);
+  error |= (N2 != memo.N || M2 != memo.M || bound2 != memo.bound);
+  rewind(fd);
+  error |= memo_load_z(memo2, fd, &stats);
+  error |= !same_cells(memo, memo2);
+  fclose(fd);
+
+  if (error) {
+    fprintf(stderr,
+            "[ERROR] compressed dump round-trip failed for N=%d, n=%d, m=%d, "
+            "bound=%d\n",
+            N, n, m, bound);
+  }
+
+  memo_free(memo);
+  memo_free(memo2);
+  return error;
+}
+
+/* Load the layers up to n of a large dump into a small table. Also check that
+ * a corrupted layer is only detected if it is loaded, and that the bound is
+ * checked. */
+static int range(int N, int n, int bound) {
+  int k, error = 0;
+  long size;
+  char *buf;
+  memo_t memo = memo_alloc(N, -1, bound);
+  memo_t small = memo_alloc(n, -1, bound);
+  memo_t other_bound = memo_alloc(n, -1, bound + 1);
+  memo_t ref = memo_alloc(n, -1, bound);
+  FILE *fd = tmpfile();
+
+  for (k = 1; k <= N; k++)
+    doag_count(memo, N, N + N / 2, k, bound);
+  for (k = 1; k <= n; k++)
+    doag_count(ref, n, n + n / 2, k, bound);
+  memo_dump_z(fd, memo, "doag", NULL);
+
+  error |= memo_load_range(small, fd, 2, n);
+  /* Compare the cells present in both tables. */
+  for (k = 1; k <= n; k++)
+    error |= mpz_cmp(*doag_count(small, n, n + n / 2, k, bound),
+                     *doag_count(ref, n, n + n / 2, k, bound)) != 0;
+  error |= (memo_load_range(other_bound, fd, 2, n) == 0);
+
+  /* Corrupt the last byte of the last layer, just before the index. */
+  buf = content(fd, &size);
+  buf[size - 16 - 20 * (N - 1) - 1] ^= 1;
+  rewind(fd);
+  fwrite(buf, 1, size, fd);
+  memo_free(small);
+  small = memo_alloc(n, -1, bound);
+  error |= memo_load_range(small, fd, 2, n);
+  memo_free(memo);
+  memo = memo_alloc(N, -1, bound);
+  error |= (memo_load_range(memo, fd, 2, N) == 0);
+
+  if (error) {
+    fprintf(stderr,
+            "[ERROR] partial loading of a compressed dump failed for N=%d, "
+            "n=%d, bound=%d\n",
+            N, n, bound);
+  }
+
+  free(buf);
+  fclose(fd);
+  memo_free(memo);
+  memo_free(small);
+  memo_free(other_bound);
+  memo_free(ref);
+  return error;
+}
+
+/* Check that truncated dumps and dumps too large for the table are rejected. */
+static int invalid(void) {
+  int k, error = 0;
+  long size;
+  char *buf;
+  memo_t memo = memo_alloc(20, -1, -1);
+  memo_t small = memo_alloc(10, -1, -1);
+  FILE *fd = tmpfile(), *fd2 = tmpfile();
+
+  for (k = 1; k <= 20; k++)
+    doag_count(memo, 20, 40, k, -1);
+  memo_dump_z(fd, memo, "doag", NULL);
+
+  rewind(fd);
+  error |= (memo_load_z(small, fd, NULL) == 0);
+
+  fseek(fd, 0, SEEK_END);
+  size = ftell(fd);
+  buf = malloc(size);
+  rewind(fd);
+  if (fread(buf, 1, size, fd) != (size_t)size)
+    error = 1;
+  fwrite(buf, 1, size / 2, fd2);
+  rewind(fd2);
+  memo_free(memo);
+  memo = memo_alloc(20, -1, -1);
+  error |= (memo_load_z(memo, fd2, NULL) == 0);
+
+  if (error)
+    fprintf(stderr, "[ERROR] an invalid compressed dump was accepted\n");
+
+  free(buf);
+  fclose(fd);
+  fclose(fd2);
+  memo_free(memo);
+  memo_free(small);
+  return error;
+}
+
+/* Check that memo_dump_parallel produces the same output as memo_dump, that
+ * memo_load and memo_load_parallel load it back correctly, and that they
+ * reject dumps too large for the table. */
+static int parallel(int N, int bound, int nb_threads) {
+  int k, error, n2, m2, b2;
+  long size, size2;
+  char *a, *b;
+  memo_t memo = memo_alloc(N, -1, bound);
+  memo_t memo2 = memo_alloc(N, -1, bound);
+  memo_t memo3 = memo_alloc(N, -1, bound);
+  memo_t small = memo_alloc(N / 2, -1, bound);
+  FILE *fd = tmpfile(), *fd2 = tmpfile();
+
+  for (k = 1; k <= N; k++)
+    doag_count(memo, N, N + N / 2, k, bound);
+
+  memo_dump(fd, memo);
+  memo_dump_parallel(fd2, memo, nb_threads);
+  a = content(fd, &size);
+  b = content(fd2, &size2);
+  error = (size != size2 || memcmp(a, b, size) != 0);
+
+  /* Skip the header, as the CLI does. */
+  rewind(fd2);
+  error |= (fscanf(fd2, "%d %d %d\n", &n2, &m2, &b2) != 3);
+  error |= memo_load_parallel(memo2, fd2, nb_threads);
+  error |= !same_cells(memo, memo2);
+
+  rewind(fd2);
+  error |= (fscanf(fd2, "%d %d %d\n", &n2, &m2, &b2) != 3);
+  error |= (memo_load_parallel(small, fd2, nb_threads) == 0);
+
+  rewind(fd2);
+  error |= (fscanf(fd2, "%d %d %d\n", &n2, &m2, &b2) != 3);
+  error |= memo_load(memo3, fd2);
+  error |= !same_cells(memo, memo3);
+
+  memo_free(small);
+  small = memo_alloc(N / 2, -1, bound);
+  rewind(fd2);
+  error |= (fscanf(fd2, "%d %d %d\n", &n2, &m2, &b2) != 3);
+  error |= (memo_load(small, fd2) == 0);
+
+  if (error) {
+    fprintf(stderr,
+            "[ERROR] parallel dump or load failed for N=%d, bound=%d with %d "
+            "threads\n",
+            N, bound, nb_threads);
+  }
+
+  free(a);
+  free(b);
+  fclose(fd);
+  fclose(fd2);
+  memo_free(memo);
+  memo_free(memo2);
+  memo_free(memo3);
+  memo_free(small);
+  return error;
+}
+
+/* Open a dump lazily for up to M edges with a memory cap of max_bytes and
+ * check that the counts read through it are the same as in the original
+ * table, including when a layer is corrupted and needs to be recomputed, and
+ * that the cap is enforced. */
+static int lazy(int N, int bound, int M, size_t max_bytes) {
+  int n, k, loaded = 0, error = 0;
+  long size;
+  char *buf;
+  memo_t memo = memo_alloc(N, -1, bound), opened;
+  FILE *fd = tmpfile();
+
+  for (k = 1; k <= N; k++)
+    doag_count(memo, N, N + N / 2, k, bound);
+  memo_dump_z(fd, memo, "doag", NULL);
+
+  /* Corrupt the first layer with more than one chunk byte. */
+  buf = content(fd, &size);
+  buf[32 + 8] ^= 1;
+  rewind(fd);
+  fwrite(buf, 1, size, fd);
+
+  if (memo_open_z(&opened, fd, M, max_bytes) != 0) {
+    error = 1;
+  } else {
+    /* Only the layers below n are needed for counting graphs of size n. */
+    n = N / 2;
+    for (k = 1; k <= n; k++)
+      error |= mpz_cmp(*doag_count(opened, n, n + n / 2, k, bound),
+                       *doag_count(memo, n, n + n / 2, k, bound)) != 0;
+    error |= (opened.vals[N - 2] != NULL);
+
+    /* The samplers walk down from N. */
+    for (n = N; n >= 2; n--) {
+      if (M >= 0 && n + n / 2 > M)
+        continue;
+      for (k = 1; k <= n; k++)
+        error |= mpz_cmp(*doag_count(opened, n, n + n / 2, k, bound),
+                         *doag_count(memo, n, n + n / 2, k, bound)) != 0;
+    }
+    memo_lazy_release(opened);
+    for (n = 2; n <= N; n++)
+      loaded += opened.vals[n - 2] != NULL;
+    error |= max_bytes > 0 && loaded == N - 1;
+    error |= M >= 0 && opened.M != M;
+    memo_free(opened);
+  }
+
+  if (error) {
+    fprintf(stderr,
+            "[ERROR] lazy loading of a compressed dump failed for N=%d, "
+            "bound=%d, max_bytes=%lu\n",
+            N, bound, (unsigned long)max_bytes);
+  }
+
+  free(buf);
+  fclose(fd);
+  memo_free(memo);
+  return error;
+}
+
+/* Fill a table layer by layer, checkpointing its first layers and resuming
+ * from them in a fresh table, and compare the result with the uninterrupted
+ * and the recursive fillings. */
+static int resume(int N, int n, int bound) {
+  int j, k, error = 0;
+  memo_t memo = memo_alloc(N, -1, bound);
+  memo_t partial, resumed = memo_alloc(N, -1, bound);
+  memo_t ref = memo_alloc(N, -1, bound);
+  const int B = bound < 0 ? N : bound;
+  FILE *fd = tmpfile();
+
+  for (j = 2; j <= n; j++)
+    memo_fill_layer(memo, doag_count, j);
+  partial = memo;
+  partial.N = n;
+  memo_dump_z(fd, partial, "doag", NULL);
+
+  error |= memo_load_range(resumed, fd, 2, n);
+  for (j = n + 1; j <= N; j++)
+    memo_fill_layer(resumed, doag_count, j);
+  for (j = n + 1; j <= N; j++)
+    memo_fill_layer(memo, doag_count, j);
+  error |= !same_cells(resumed, memo);
+  for (k = 1; k <= N; k++)
+    for (j = N - k; j <= N + N / 2; j++)
+      error |= mpz_cmp(*doag_count(resumed, N, j, k, B),
+                       *doag_count(ref, N, j, k, B)) != 0;
+
+  if (error) {
+    fprintf(stderr,
+            "[ERROR] resuming a layer-wise filling failed for N=%d, n=%d, "
+            "bound=%d\n",
+            N, n, bound);
+  }
+
+  fclose(fd);
+  memo_free(memo);
+  memo_free(resumed);
+  memo_free(ref);
+  return error;
+}
+
+int main() {
+  int error = 0;
+
+  error |= roundtrip(2, 2, 1, -1);
+  error |= roundtrip(25, 25, 60, -1);
+  error |= roundtrip(30, 20, 35, -1);
+  error |= roundtrip(40, 40, 80, 2);
+  error |= range(30, 12, 3);
+  error |= range(25, 20, -1);
+  error |= invalid();
+  error |= lazy(30, -1, -1, 0);
+  error |= lazy(30, 4, -1, 1 << 16);
+  error |= lazy(30, -1, 40, 1);
+  error |= resume(25, 12, -1);
+  error |= resume(30, 20, 3);
+
+  error |= parallel(20, -1, 1);
+  error |= parallel(25, -1, 3);
+  error |= parallel(30, 2, 8);
+
+  fprintf(stderr, "TEST dumps: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+/* Number of sources and sinks of g. */
+static void sources_sinks(randdag_t g, int *sources, int *sinks) {
+  int i, j, min_id;
+  int *in_degree = calloc(g.N > 0 ? g.N : 1, sizeof(int));
+
+  min_id = g.N > 0 ? g.v[0].id : 0;
+  for (i = 1; i < g.N; i++) {
+    if (g.v[i].id < min_id)
+      min_id = g.v[i].id;
+  }
+  *sources = *sinks = 0;
+  for (i = 0; i < g.N; i++) {
+    *sinks += g.v[i].out_degree == 0;
+    for (j = 0; j < g.v[i].out_degree; j++)
+      in_degree[g.v[i].out_edges[j].id - min_id]++;
+  }
+  for (i = 0; i < g.N; i++)
+    *sources += in_degree[i] == 0;
+  free(in_degree);
+}
+
+/* Check that g has n vertices, m edges and k sources (if non-negative) and
+ * out-degree bounded by bound (if non-negative). */
+static int check_graph(randdag_t g, int n, int m, int k, int bound) {
+  int i, j, min_id, nb_edges = 0, nb_sources = 0, error = 0;
+  int *in_degree = calloc(n > 0 ? n : 1, sizeof(int));
+
+  min_id = n > 0 ? g.v[0].id : 0;
+  for (i = 1; i < g.N; i++) {
+    if (g.v[i].id < min_id)
+      min_id = g.v[i].id;
+  }
+  for (i = 0; i < g.N; i++) {
+    nb_edges += g.v[i].out_degree;
+    error |= bound >= 0 && g.v[i].out_degree > bound;
+    for (j = 0; j < g.v[i].out_degree; j++)
+      in_degree[g.v[i].out_edges[j].id - min_id]++;
+  }
+  for (i = 0; i < g.N; i++)
+    nb_sources += in_degree[i] == 0;
+
+  error |= g.N != n;
+  error |= m >= 0 && nb_edges != m;
+  error |= k >= 0 && nb_sources != k;
+  free(in_degree);
+  return error;
+}
+
+/* Sample a few graphs with the engine chosen for these parameters, which must
+ * be the expected one. */
+static int engine(int n, int m, int k, int bound, unsigned long count,
+                  size_t max_bytes, int expected) {
+  int i, error = 0;
+  gmp_randstate_t state;
+  const sampler_plan_t plan = doag_plan(n, m, k, bound, count, max_bytes);
+  memo_t memo = memo_alloc(plan.needs_memo ? n : 0, m, bound);
+
+  if (plan.engine != expected) {
+    fprintf(stderr,
+            "[ERROR] doag_plan(%d, %d, %d, %d, %lu, %lu) chose the %s engine "
+            "instead of the %s engine\n",
+            n, m, k, bound, count, (unsigned long)max_bytes,
+            sampler_engine_name(plan.engine), sampler_engine_name(expected));
+    error = 1;
+  }
+
+  gmp_randinit_default(state);
+  for (i = 0; i < 5; i++) {
+    randdag_t g = doag_unif_engine(state, memo, plan.engine, n, m, k, bound);
+    if (check_graph(g, n, m, k, bound)) {
+      fprintf(stderr,
+              "[ERROR] the %s engine drew a wrong graph for n=%d, m=%d, k=%d "
+              "and bound=%d\n",
+              sampler_engine_name(plan.engine), n, m, k, bound);
+      error = 1;
+    }
+    randdag_free(g);
+  }
+  gmp_randclear(state);
+  memo_free(memo);
+  return error;
+}
+
+/* The rejection sampler draws DOAGs with a single source and a single sink.
+ * It must be chosen for all the requests where only n is fixed, and only for
+ * them, so that the class of the output does not depend on n. */
+static int rejection(void) {
+  int n, i, sources, sinks, error = 0;
+  gmp_randstate_t state;
+  memo_t memo = memo_alloc(0, 0, -1);
+
+  gmp_randinit_default(state);
+  for (n = 0; n <= 40; n++) {
+    error |= doag_plan(n, -1, -1, -1, 1, 0).engine != RD_ENGINE_REJECTION;
+    error |= n > 1 && doag_plan(n, -1, -1, n, 1, 0).engine ==
+                          RD_ENGINE_REJECTION;
+    for (i = 0; i < 20; i++) {
+      randdag_t g =
+          doag_unif_engine(state, memo, RD_ENGINE_REJECTION, n, -1, -1, -1);
+      sources_sinks(g, &sources, &sinks);
+      error |= g.N != n || (n > 0 && (sources != 1 || sinks != 1));
+      randdag_free(g);
+    }
+  }
+  if (error)
+    fprintf(stderr, "[ERROR] wrong use of the rejection sampler\n");
+
+  gmp_randclear(state);
+  memo_free(memo);
+  return error;
+}
+
+/* The engines for graphs whose numbers of edges and sources are free must
+ * draw from the same distribution: compare their mean number of sources with
+ * the exact one. */
+static int same_distribution(int n, int bound) {
+  static const int engines[3] = {RD_ENGINE_SMALL, RD_ENGINE_COMPACT,
+                                 RD_ENGINE_RECURSIVE};
+  const int count = 4000;
+  int e, i, k, sources, sinks, error = 0;
+  double mean = 0, var = 0, total;
+  mpz_t x;
+  gmp_randstate_t state;
+  memo_t memo = memo_alloc(n, -1, bound);
+  memo_nk_t memo_nk = memo_nk_alloc(n, bound);
+
+  /* The exact mean and variance of the number of sources. */
+  mpz_init(x);
+  for (k = 1; k <= n; k++)
+    mpz_add(x, x, *doag_count_nk(memo_nk, n, k, bound));
+  total = mpz_get_d(x);
+  for (k = 1; k <= n; k++) {
+    const double p = mpz_get_d(*doag_count_nk(memo_nk, n, k, bound)) / total;
+    mean += k * p;
+    var += (double)k * k * p;
+  }
+  var -= mean * mean;
+  mpz_clear(x);
+  memo_nk_free(memo_nk);
+
+  gmp_randinit_default(state);
+  for (e = 0; e < 3; e++) {
+    double sum = 0;
+    for (i = 0; i < count; i++) {
+      randdag_t g =
+          doag_unif_engine(state, memo, engines[e], n, -1, -1, bound);
+      sources_sinks(g, &sources, &sinks);
+      sum += sources;
+      randdag_free(g);
+    }
+    /* Five standard deviations of the empirical mean. */
+    if ((sum / count - mean) * (sum / count - mean) > 25 * var / count) {
+      fprintf(stderr,
+              "[ERROR] the %s engine drew %.3f sources on average instead "
+              "of %.3f for n=%d and bound=%d\n",
+              sampler_engine_name(engines[e]), sum / count, mean, n, bound);
+      error = 1;
+    }
+  }
+
+  gmp_randclear(state);
+  memo_free(memo);
+  return error;
+}
+
+int main() {
+  int error = 0;
+
+  /* Only n is fixed. */
+  error |= rejection();
+  error |= engine(1, -1, -1, -1, 1, 0, RD_ENGINE_REJECTION);
+  error |= engine(2, -1, -1, -1, 1, 0, RD_ENGINE_REJECTION);
+  error |= engine(100, -1, -1, -1, 1000, 0, RD_ENGINE_REJECTION);
+  /* Tiny graphs use machine integers. */
+  error |= engine(8, 10, -1, 2, 1, 0, RD_ENGINE_SMALL);
+  error |= engine(8, -1, -1, 2, 1, 0, RD_ENGINE_SMALL);
+  /* The engines for the other requests sample the same class. */
+  error |= same_distribution(8, 3);
+  error |= same_distribution(12, 7);
+  /* Fixed number of edges or sources. */
+  error |= engine(30, 50, -1, -1, 1, 0, RD_ENGINE_RECURSIVE);
+  error |= engine(25, -1, 4, 3, 1, 0, RD_ENGINE_RECURSIVE);
+  error |= engine(25, 40, 4, -1, 1, 0, RD_ENGINE_RECURSIVE);
+  /* Only the out-degree is bounded: the full table pays off for many
+   * graphs, if it fits. */
+  error |= engine(40, -1, -1, 3, 1, 0, RD_ENGINE_COMPACT);
+  error |= engine(40, -1, -1, 3, 100000, 0, RD_ENGINE_RECURSIVE);
+  error |= engine(40, -1, -1, 3, 100000, 100000, RD_ENGINE_COMPACT);
+
+  /* Nothing fits. */
+  error |= doag_plan(40, 50, -1, -1, 1, 1000).fits;
+  error |= !doag_plan(40, 50, -1, -1, 1, 0).fits;
+
+  fprintf(stderr, "TEST sampling engines: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
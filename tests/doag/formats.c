@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+/* Read a little-endian integer over nb bytes. */
+static unsigned long read_le(FILE *fd, int nb) {
+  int i;
+  unsigned long x = 0;
+  for (i = 0; i < nb; i++)
+    x |= (unsigned long)getc(fd) << (8 * i);
+  return x;
+}
+
+static int check_header(FILE *fd, const char *magic, const randdag_t g,
+                        unsigned long M) {
+  char buf[4];
+  if (fread(buf, 1, 4, fd) != 4 || memcmp(buf, magic, 4) != 0)
+    return 1;
+  return read_le(fd, 4) != 1 || read_le(fd, 8) != (unsigned long)g.N ||
+         read_le(fd, 8) != M;
+}
+
+/* Write g in all the formats, read it back and compare. The ids of g are
+ * 0, ..., N-1. */
+static int roundtrip(const randdag_t g) {
+  int i, j, error = 0;
+  unsigned long u, v, M = 0, offset;
+  FILE *fd;
+
+  for (i = 0; i < g.N; i++)
+    M += g.v[i].out_degree;
+
+  /* Text edge list. */
+  fd = tmpfile();
+  error |= randdag_write(fd, g, RD_FMT_EDGES, 0);
+  rewind(fd);
+  for (i = 0; i < g.N; i++) {
+    for (j = 0; j < g.v[i].out_degree; j++) {
+      error |= (fscanf(fd, "%lu %lu\n", &u, &v) != 2);
+      error |= (u != (unsigned long)g.v[i].id);
+      error |= (v != (unsigned long)g.v[i].out_edges[j].id);
+    }
+  }
+  error |= (getc(fd) != EOF);
+  fclose(fd);
+
+  /* Binary edge list. */
+  fd = tmpfile();
+  error |= randdag_write(fd, g, RD_FMT_BIN_EDGES, 0);
+  rewind(fd);
+  error |= check_header(fd, "RDEL", g, M);
+  for (i = 0; i < g.N; i++) {
+    for (j = 0; j < g.v[i].out_degree; j++) {
+      error |= (read_le(fd, 4) != (unsigned long)g.v[i].id);
+      error |= (read_le(fd, 4) != (unsigned long)g.v[i].out_edges[j].id);
+    }
+  }
+  error |= (getc(fd) != EOF);
+  fclose(fd);
+
+  /* CSR: vertex i is the vertex of id i. */
+  fd = tmpfile();
+  error |= randdag_write(fd, g, RD_FMT_CSR, 0);
+  rewind(fd);
+  error |= check_header(fd, "RDCS", g, M);
+  offset = 0;
+  error |= (read_le(fd, 8) != 0);
+  for (u = 0; u < (unsigned long)g.N; u++) {
+    for (i = 0; g.v[i].id != (int)u; i++) {
+    }
+    offset += g.v[i].out_degree;
+    error |= (read_le(fd, 8) != offset);
+  }
+  for (u = 0; u < (unsigned long)g.N; u++) {
+    for (i = 0; g.v[i].id != (int)u; i++) {
+    }
+    for (j = 0; j < g.v[i].out_degree; j++)
+      error |= (read_le(fd, 4) != (unsigned long)g.v[i].out_edges[j].id);
+  }
+  error |= (getc(fd) != EOF);
+  fclose(fd);
+
+  if (error)
+    fprintf(stderr, "[ERROR] randdag_write failed on a graph of size %d\n",
+            g.N);
+  return error;
+}
+
+/* Check that doag_unif_n_csr writes the same graph as doag_unif_n followed by
+ * randdag_write in CSR format. */
+static int direct_csr(const char *filename, int n, unsigned long seed) {
+  int c, error = 0;
+  gmp_randstate_t state;
+  randdag_t g;
+  FILE *ref = tmpfile(), *fd;
+
+  gmp_randinit_default(state);
+  gmp_randseed_ui(state, seed);
+  g = doag_unif_n(state, n);
+  error |= randdag_write(ref, g, RD_FMT_CSR, 0);
+  randdag_free(g);
+
+  gmp_randseed_ui(state, seed);
+  error |= doag_unif_n_csr(state, n, filename);
+
+  fd = fopen(filename, "rb");
+  rewind(ref);
+  if (fd == NULL) {
+    error = 1;
+  } else {
+    while ((c = getc(ref)) != EOF)
+      error |= (c != getc(fd));
+    error |= (getc(fd) != EOF);
+    fclose(fd);
+  }
+  remove(filename);
+
+  if (error)
+    fprintf(stderr, "[ERROR] doag_unif_n_csr failed for n=%d\n", n);
+
+  fclose(ref);
+  gmp_randclear(state);
+  return error;
+}
+
+int main(int argc, char *argv[]) {
+  int n, error = 0;
+  char filename[200];
+  gmp_randstate_t state;
+
+  gmp_randinit_default(state);
+  gmp_randseed_ui(state, 0xdeadbeef);
+
+  for (n = 3; n <= 300; n += 23) {
+    randdag_t g = doag_unif_n(state, n);
+    error |= roundtrip(g);
+    randdag_free(g);
+  }
+
+  gmp_randclear(state);
+
+  /* Write the CSR files next to the test executable. */
+  (void)argc;
+  sprintf(filename, "%.190s.csr", argv[0]);
+  for (n = 3; n <= 2000; n = 2 * n + 1)
+    error |= direct_csr(filename, n, n);
+
+  fprintf(stderr, "TEST output formats: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
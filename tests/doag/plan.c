@@ -0,0 +1,74 @@
+#include <stdio.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Compare the estimate of memo_plan with the actual size of a filled table,
+ * counted as memo_plan does: it must be an upper bound, by at most 50%. */
+static int estimate(int N, int M, int bound) {
+  int n, m, k, error = 0;
+  double bytes = 0;
+  memo_t memo = memo_alloc(N, M, bound);
+  const memo_plan_t plan = memo_plan("doag", N, M, bound, 0, 1, 0);
+
+  for (n = 2; n <= N; n++) {
+    memo_fill_layer(memo, doag_count, n);
+    for (k = 1; k <= n; k++) {
+      const int C = min(memo.bound, n - k);
+      const int max_m = min((C - 1) * C / 2 + C * (n - C), memo.M);
+      for (m = 0; m <= max_m; m++) {
+        mpz_t *x = memo_get_ptr(memo, n, m, k);
+        bytes += sizeof(mpz_t);
+        if (mpz_sgn(*x) != 0)
+          bytes += mpz_size(*x) * sizeof(mp_limb_t) + 16;
+      }
+    }
+  }
+
+  if (plan.strategy != MEMO_DENSE || plan.dense < bytes ||
+      plan.dense > 1.5 * bytes) {
+    fprintf(stderr,
+            "[ERROR] memo_plan(%d, %d, %d) estimated %.0f bytes instead of "
+            "%.0f\n",
+            N, M, bound, plan.dense, bytes);
+    error = 1;
+  }
+  memo_free(memo);
+  return error;
+}
+
+/* Check the choice of the strategy for various budgets. */
+static int strategies(int N) {
+  int error = 0;
+  const memo_plan_t plan = memo_plan("doag", N, -1, -1, 0, 1, 0);
+  const size_t rolling = (size_t)plan.rolling, ooc = (size_t)plan.out_of_core;
+
+  error |= !(plan.out_of_core <= plan.rolling && plan.rolling < plan.dense);
+  error |= memo_plan("doag", N, -1, -1, rolling + 1, 0, 0).strategy !=
+           MEMO_ROLLING;
+  error |= memo_plan("doag", N, -1, -1, rolling + 1, 1, 0).strategy !=
+           MEMO_NONE;
+  error |= memo_plan("doag", N, -1, -1, ooc + 1, 1, 1).strategy !=
+           MEMO_OUT_OF_CORE;
+  error |= memo_plan("doag", N, -1, -1, ooc / 2, 0, 1).strategy != MEMO_NONE;
+  /* DOAGs are counted with more bits than LDAGs. */
+  error |= memo_plan("ldag", N, -1, -1, 0, 1, 0).dense >= plan.dense;
+
+  if (error)
+    fprintf(stderr, "[ERROR] memo_plan chose a wrong strategy for N=%d\n", N);
+  return error;
+}
+
+int main() {
+  int error = 0;
+
+  error |= estimate(30, -1, -1);
+  error |= estimate(35, 150, -1);
+  error |= estimate(40, -1, 3);
+  error |= strategies(100);
+
+  fprintf(stderr, "TEST memory plans: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
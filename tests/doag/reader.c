@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+/* Compare a view with the graph it was written from. The ids of g are
+ * consecutive. */
+static int same_graph(const randdag_csr_t *view, const randdag_t g,
+                      int format) {
+  int i, j, min_id = 0, error = 0;
+  unsigned long M = 0, e = 0;
+  int *pos = malloc((g.N + 1) * sizeof(int));
+
+  for (i = 0; i < g.N; i++) {
+    M += g.v[i].out_degree;
+    if (i == 0 || g.v[i].id < min_id)
+      min_id = g.v[i].id;
+  }
+  for (i = 0; i < g.N; i++)
+    pos[g.v[i].id - min_id] = i;
+  error |= (view->format != format);
+  error |= (view->N != (unsigned long)g.N || view->M != M);
+
+  /* Edge lists follow the order of g.v, CSR the order of the ids. */
+  for (i = 0; !error && i < g.N; i++) {
+    const randdag_vertex u = g.v[format == RD_FMT_CSR ? pos[i] : i];
+    if (format == RD_FMT_CSR)
+      error |= (randdag_csr_offset(*view, i) != e);
+    for (j = 0; j < u.out_degree; j++, e++) {
+      if (format == RD_FMT_BIN_EDGES)
+        error |=
+            (randdag_csr_source(*view, e) != (unsigned long)(u.id - min_id));
+      error |= (randdag_csr_target(*view, e) !=
+                (unsigned long)(u.out_edges[j].id - min_id));
+    }
+  }
+  if (format == RD_FMT_CSR)
+    error |= (randdag_csr_offset(*view, g.N) != M);
+
+  free(pos);
+  return error;
+}
+
+/* Write nb graphs in the given format, both to a single file and to shards,
+ * and read them back in a random order. */
+static int reader(const char *prefix, int nb, int format) {
+  int i, error = 0;
+  char filename[256];
+  unsigned long shard;
+  gmp_randstate_t state;
+  memo_t memo = memo_alloc(20, -1, -1);
+  randdag_t *graphs = malloc(nb * sizeof(randdag_t));
+  randdag_shards_t *s = randdag_shards_open(prefix, format, 0, 1 << 12, 0);
+  randdag_reader_t *file, *corpus;
+  randdag_csr_t view;
+  FILE *fd;
+
+  sprintf(filename, "%s.all", prefix);
+  fd = fopen(filename, "wb");
+  gmp_randinit_default(state);
+  for (i = 0; i < nb; i++) {
+    graphs[i] = doag_unif_nm(state, memo, 3 + i % 18, 2 + 2 * (i % 18), -1);
+    error |= randdag_write(fd, graphs[i], format, 0);
+    error |= randdag_shards_write(s, graphs[i]);
+  }
+  fclose(fd);
+  error |= randdag_shards_close(s);
+
+  file = randdag_reader_open(filename);
+  corpus = randdag_corpus_open(prefix);
+  error |= (file == NULL || corpus == NULL);
+  if (!error) {
+    error |= (randdag_reader_len(file) != (unsigned long)nb);
+    error |= (randdag_reader_len(corpus) != (unsigned long)nb);
+    error |= (randdag_reader_get(file, nb, &view) == 0);
+    for (i = 0; !error && i < nb; i++) {
+      /* Visit the graphs in a scrambled order. */
+      const int j = (int)((7919UL * i) % nb);
+      error |= randdag_reader_get(file, j, &view) ||
+               same_graph(&view, graphs[j], format);
+      error |= randdag_reader_get(corpus, j, &view) ||
+               same_graph(&view, graphs[j], format);
+    }
+  }
+
+  if (error) {
+    fprintf(stderr, "[ERROR] reading %d graphs back failed for format=%d\n",
+            nb, format);
+  }
+
+  /* Cleanup. */
+  if (file != NULL)
+    randdag_reader_close(file);
+  if (corpus != NULL)
+    randdag_reader_close(corpus);
+  for (shard = 0;; shard++) {
+    sprintf(filename, "%s.%lu", prefix, shard);
+    if (remove(filename) != 0)
+      break;
+  }
+  sprintf(filename, "%s.all", prefix);
+  remove(filename);
+  sprintf(filename, "%s.idx", prefix);
+  remove(filename);
+  for (i = 0; i < nb; i++)
+    randdag_free(graphs[i]);
+  free(graphs);
+  memo_free(memo);
+  gmp_randclear(state);
+  return error;
+}
+
+/* Write an index with the given content next to a shard holding g. Return
+ * the corpus opened from it. */
+static randdag_reader_t *corpus_with_index(const char *prefix, randdag_t g,
+                                           const char *index) {
+  char filename[256];
+  randdag_reader_t *r;
+  FILE *fd;
+
+  sprintf(filename, "%s.0", prefix);
+  fd = fopen(filename, "wb");
+  randdag_write(fd, g, RD_FMT_CSR, 0);
+  fclose(fd);
+  sprintf(filename, "%s.idx", prefix);
+  fd = fopen(filename, "w");
+  fputs(index, fd);
+  fclose(fd);
+
+  r = randdag_corpus_open(prefix);
+  remove(filename);
+  sprintf(filename, "%s.0", prefix);
+  remove(filename);
+  return r;
+}
+
+/* Check that files which are not in a binary format, and corrupted indexes,
+ * are rejected. */
+static int invalid(const char *prefix) {
+  int error = 0;
+  char filename[256];
+  gmp_randstate_t state;
+  memo_t memo = memo_alloc(10, -1, -1);
+  randdag_t g;
+  randdag_csr_t view;
+  randdag_reader_t *r;
+  FILE *fd;
+
+  gmp_randinit_default(state);
+  g = doag_unif_nm(state, memo, 10, 15, -1);
+  sprintf(filename, "%s.dot", prefix);
+  fd = fopen(filename, "wb");
+  randdag_write(fd, g, RD_FMT_DOT, 0);
+  fclose(fd);
+  error |= (randdag_reader_open(filename) != NULL);
+  remove(filename);
+  error |= (randdag_reader_open(filename) != NULL);
+  error |= (randdag_corpus_open(filename) != NULL);
+
+  /* Graphs smaller than their header. */
+  r = corpus_with_index(prefix, g, "0 0 0\n0 0 8\n");
+  error |= r == NULL || randdag_reader_get(r, 0, &view) == 0 ||
+           randdag_reader_get(r, 1, &view) == 0;
+  if (r != NULL)
+    randdag_reader_close(r);
+  /* Shard numbers that cannot be those of a corpus. */
+  error |= corpus_with_index(prefix, g, "1 0 24\n") != NULL;
+  error |= corpus_with_index(prefix, g, "18446744073709551615 0 24\n") !=
+           NULL;
+
+  if (error)
+    fprintf(stderr, "[ERROR] invalid graph files are not rejected\n");
+
+  randdag_free(g);
+  memo_free(memo);
+  gmp_randclear(state);
+  return error;
+}
+
+int main(int argc, char *argv[]) {
+  int error = 0;
+  char prefix[200];
+
+  /* Write the files next to the test executable. */
+  (void)argc;
+  sprintf(prefix, "%.190s.out", argv[0]);
+
+  error |= reader(prefix, 1, RD_FMT_CSR);
+  error |= reader(prefix, 500, RD_FMT_CSR);
+  error |= reader(prefix, 500, RD_FMT_BIN_EDGES);
+  error |= invalid(prefix);
+
+  fprintf(stderr, "TEST binary reader: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+/* Read the whole content of a file, or return NULL if it does not exist. */
+static char *content(const char *filename, long *size) {
+  char *buf;
+  FILE *fd = fopen(filename, "rb");
+
+  if (fd == NULL)
+    return NULL;
+  fseek(fd, 0, SEEK_END);
+  *size = ftell(fd);
+  rewind(fd);
+  buf = malloc(*size + 1);
+  if (fread(buf, 1, *size, fd) != (size_t)*size)
+    *size = -1;
+  fclose(fd);
+  return buf;
+}
+
+/* Write nb graphs to shards with the given limits and, in parallel, to a
+ * single file. Check that the graphs found through the index are the ones of
+ * the single file, in the same order, and that the limits are respected. */
+static int shards(const char *prefix, int nb, int format,
+                  unsigned long max_bytes, unsigned long max_graphs) {
+  int i, error = 0;
+  long ref_size, size = 0, ref_offset = 0;
+  unsigned long shard, offset, len, cur_shard = 0, cur_graphs = 0;
+  char *ref, *buf = NULL, filename[256];
+  gmp_randstate_t state;
+  memo_t memo = memo_alloc(20, -1, 3);
+  FILE *fd = tmpfile(), *index;
+  randdag_shards_t *s = randdag_shards_open(prefix, format, 0, max_bytes,
+                                            max_graphs);
+
+  gmp_randinit_default(state);
+  for (i = 0; i < nb; i++) {
+    randdag_t g = doag_unif_nm(state, memo, 3 + i % 18, 2 + i % 18, 3);
+    error |= randdag_shards_write(s, g);
+    error |= randdag_write(fd, g, format, 0);
+    randdag_free(g);
+  }
+  error |= randdag_shards_close(s);
+
+  fseek(fd, 0, SEEK_END);
+  ref_size = ftell(fd);
+  rewind(fd);
+  ref = malloc(ref_size + 1);
+  error |= (fread(ref, 1, ref_size, fd) != (size_t)ref_size);
+
+  sprintf(filename, "%s.idx", prefix);
+  index = fopen(filename, "r");
+  error |= (index == NULL);
+  for (i = 0; !error && i < nb; i++) {
+    if (fscanf(index, "%lu %lu %lu\n", &shard, &offset, &len) != 3) {
+      error = 1;
+      break;
+    }
+    /* Move to the next shard. */
+    if (buf == NULL || shard != cur_shard) {
+      error |= (buf != NULL && (shard != cur_shard + 1 || offset != 0 ||
+                                (long)(offset + len) > size));
+      cur_shard = shard;
+      cur_graphs = 0;
+      free(buf);
+      sprintf(filename, "%s.%lu", prefix, shard);
+      buf = content(filename, &size);
+      error |= (buf == NULL);
+      if (error)
+        break;
+    }
+    cur_graphs++;
+    error |= (max_graphs > 0 && cur_graphs > max_graphs);
+    error |= (max_bytes > 0 && cur_graphs > 1 && offset + len > max_bytes);
+    error |= ((long)(offset + len) > size || ref_offset + (long)len > ref_size);
+    error |= !error && memcmp(buf + offset, ref + ref_offset, len) != 0;
+    ref_offset += len;
+  }
+  error |= (ref_offset != ref_size);
+
+  if (error) {
+    fprintf(stderr,
+            "[ERROR] sharded output of %d graphs failed for format=%d, "
+            "max_bytes=%lu, max_graphs=%lu\n",
+            nb, format, max_bytes, max_graphs);
+  }
+
+  /* Cleanup. */
+  if (index != NULL)
+    fclose(index);
+  sprintf(filename, "%s.idx", prefix);
+  remove(filename);
+  for (shard = 0; shard <= cur_shard; shard++) {
+    sprintf(filename, "%s.%lu", prefix, shard);
+    remove(filename);
+  }
+  free(buf);
+  free(ref);
+  fclose(fd);
+  memo_free(memo);
+  gmp_randclear(state);
+  return error;
+}
+
+int main(int argc, char *argv[]) {
+  int error = 0;
+  char prefix[200];
+
+  /* Write the shards next to the test executable. */
+  (void)argc;
+  sprintf(prefix, "%.190s.out", argv[0]);
+
+  error |= shards(prefix, 1, RD_FMT_DOT, 0, 0);
+  error |= shards(prefix, 500, RD_FMT_EDGES, 0, 0);
+  error |= shards(prefix, 500, RD_FMT_CSR, 0, 64);
+  error |= shards(prefix, 2000, RD_FMT_DOT, 1 << 16, 0);
+  error |= shards(prefix, 2000, RD_FMT_BIN_EDGES, 1 << 12, 10);
+
+  fprintf(stderr, "TEST sharded output: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
@@ -90,9 +90,37 @@ static int small_cases() {
   return error;
 }
 
+/* The totals of the layers, accumulated while they are filled. */
+static int layer_totals() {
+  int n, error = 0;
+  mpz_t x;
+  memo_t memo = memo_alloc(6, -1, -1);
+  const unsigned long expected[7] = {0, 0, 2, 8, 95, 4858, 1336729};
+
+  mpz_init(x);
+  for (n = 2; n <= 6; n++) {
+    memo_fill_layer_total(memo, doag_count, n, -1, x);
+    if (mpz_cmp_ui(x, expected[n]) != 0) {
+      fprintf(stderr, "[ERROR] wrong total for the layer %d\n", n);
+      error = 1;
+    }
+  }
+  /* Restricted to at most 3 edges, the cells being filled already. */
+  memo_fill_layer_total(memo, doag_count, 5, 3, x);
+  if (mpz_cmp_ui(x, 1 + 4 + 15 + 48) != 0) {
+    fprintf(stderr, "[ERROR] wrong total for the layer 5 and m <= 3\n");
+    error = 1;
+  }
+
+  memo_free(memo);
+  mpz_clear(x);
+  return error;
+}
+
 int main() {
   int error;
   error = small_cases();
+  error |= layer_totals();
   fprintf(stderr, "TEST (n,m)-small cases: %s\n", error ? "FAILED" : "OK");
   return error;
 }
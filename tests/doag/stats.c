@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+#define BUF_LEN 16384
+
+/* Print stats to buf. */
+static void print(const randdag_stats_t *stats, char *buf) {
+  size_t len;
+  FILE *fd = tmpfile();
+
+  randdag_stats_print(fd, stats, 1);
+  rewind(fd);
+  len = fread(buf, 1, BUF_LEN - 1, fd);
+  buf[len] = '\0';
+  fclose(fd);
+}
+
+/* The graph 3 -> 1 -> 0 and 3 -> 0, plus the isolated vertex 2. The ids start
+ * at 0 as in the graphs of the library. */
+static int known_graph() {
+  int i, error = 0;
+  randdag_stats_t *stats;
+  randdag_t g = randdag_alloc(4);
+  char buf[BUF_LEN], ref[BUF_LEN];
+  /* The expected output, line by line. */
+  const char *expected[] = {
+      "statistic            count         mean       stddev    min     p5    "
+      "p25    p50    p75    p95    max\n",
+      "edges                    1       3.0000       0.0000      3      3      "
+      "3      3      3      3      3\n",
+      "sources                  1       2.0000       0.0000      2      2      "
+      "2      2      2      2      2\n",
+      "sinks                    1       2.0000       0.0000      2      2      "
+      "2      2      2      2      2\n",
+      "depth                    1       2.0000       0.0000      2      2      "
+      "2      2      2      2      2\n",
+      "in-degree                4       0.7500       0.9574      0      0      "
+      "0      0      1      2      2\n",
+      "\nhistogram of edges:\n",
+      "     3          1\n",
+      "\nhistogram of sources:\n",
+      "     2          1\n",
+      "\nhistogram of sinks:\n",
+      "     2          1\n",
+      "\nhistogram of depth:\n",
+      "     2          1\n",
+      "\nhistogram of in-degree:\n",
+      "     0          2\n",
+      "     1          1\n",
+      "     2          1\n",
+      NULL};
+
+  g.v[0].id = 3;
+  g.v[0].out_degree = 2;
+  g.v[0].out_edges = malloc(2 * sizeof(randdag_vertex));
+  g.v[0].out_edges[0].id = 1;
+  g.v[0].out_edges[1].id = 0;
+  g.v[1].id = 2;
+  g.v[1].out_degree = 0;
+  g.v[2].id = 1;
+  g.v[2].out_degree = 1;
+  g.v[2].out_edges = malloc(sizeof(randdag_vertex));
+  g.v[2].out_edges[0].id = 0;
+  g.v[3].id = 0;
+  g.v[3].out_degree = 0;
+
+  stats = randdag_stats_alloc(randdag_stats_flags("edges,sources,sinks,depth,"
+                                                  "in-degree"));
+  randdag_stats_add(stats, g);
+  print(stats, buf);
+  ref[0] = '\0';
+  for (i = 0; expected[i] != NULL; i++)
+    strcat(ref, expected[i]);
+  error |= strcmp(buf, ref) != 0;
+  if (error)
+    fprintf(stderr, "[ERROR] wrong statistics for a known graph\n");
+
+  error |= randdag_stats_flags("edges,foo") != 0;
+  error |= randdag_stats_flags("all") != RD_STAT_ALL;
+  error |=
+      randdag_stats_flags("depth,sinks") != (RD_STAT_DEPTH | RD_STAT_SINKS);
+
+  randdag_stats_free(stats);
+  randdag_free(g);
+  return error;
+}
+
+/* A source with d out-edges to d sinks. */
+static randdag_t star(int d) {
+  int i;
+  randdag_t g = randdag_alloc(d + 1);
+
+  g.v[0].id = d;
+  g.v[0].out_degree = d;
+  g.v[0].out_edges = malloc(d * sizeof(randdag_vertex));
+  for (i = 0; i < d; i++) {
+    g.v[0].out_edges[i].id = i;
+    g.v[i + 1].id = i;
+    g.v[i + 1].out_degree = 0;
+  }
+  return g;
+}
+
+/* Values too large for the dense part of the histograms, in two aggregates
+ * that are then merged. */
+static int large_values() {
+  int error;
+  char buf[BUF_LEN];
+  randdag_stats_t *stats = randdag_stats_alloc(RD_STAT_EDGES);
+  randdag_stats_t *part = randdag_stats_alloc(RD_STAT_EDGES);
+  randdag_t g;
+
+  g = star(2000);
+  randdag_stats_add(stats, g);
+  randdag_free(g);
+  g = star(5000);
+  randdag_stats_add(part, g);
+  randdag_stats_add(part, g);
+  randdag_free(g);
+  randdag_stats_merge(stats, part);
+
+  print(stats, buf);
+  error = strcmp(buf,
+                 "statistic            count         mean       stddev    min  "
+                 "   p5    p25    p50    p75    p95    max\n"
+                 "edges                    3    4000.0000    1732.0508   2000  "
+                 " 2000   2000   5000   5000   5000   5000\n"
+                 "\nhistogram of edges:\n"
+                 "  2000          1\n"
+                 "  5000          2\n") != 0;
+  if (error)
+    fprintf(stderr, "[ERROR] wrong statistics for large values\n");
+
+  randdag_stats_free(stats);
+  randdag_stats_free(part);
+  return error;
+}
+
+static memo_t memo;
+
+static randdag_t sample(gmp_randstate_t state, unsigned long i, void *arg) {
+  (void)arg;
+  randdag_seed_stream(state, 0xdeadbeef, i);
+  return doag_unif_nm(state, memo, 15, 30, 3);
+}
+
+/* The aggregate does not depend on the number of threads, nor on how the
+ * graphs are split before merging. */
+static int threads(unsigned long count) {
+  int t, error = 0;
+  char ref[BUF_LEN], buf[BUF_LEN];
+  randdag_stats_t *stats = randdag_stats_alloc(RD_STAT_ALL);
+  randdag_stats_t *part = randdag_stats_alloc(RD_STAT_ALL);
+  gmp_randstate_t state;
+
+  /* Sequentially, in two parts. */
+  gmp_randinit_default(state);
+  for (t = 0; t < 2; t++) {
+    unsigned long i;
+    for (i = t * count / 2; i < (t + 1) * count / 2; i++) {
+      randdag_t g = sample(state, i, NULL);
+      randdag_stats_add(t == 0 ? stats : part, g);
+      randdag_free(g);
+    }
+  }
+  randdag_stats_merge(stats, part);
+  print(stats, ref);
+  randdag_stats_free(stats);
+  randdag_stats_free(part);
+  gmp_randclear(state);
+
+  for (t = 1; t <= 4; t++) {
+    stats = randdag_stats_alloc(RD_STAT_ALL);
+    randdag_stats_sample(stats, sample, NULL, count, t);
+    print(stats, buf);
+    if (strcmp(buf, ref) != 0) {
+      fprintf(stderr, "[ERROR] different statistics with %d threads\n", t);
+      error = 1;
+    }
+    randdag_stats_free(stats);
+  }
+
+  return error;
+}
+
+int main() {
+  int n, error = 0;
+
+  /* The table must be complete to be shared by several threads. */
+  memo = memo_alloc(15, 30, 3);
+  for (n = 2; n <= 15; n++)
+    memo_fill_layer(memo, doag_count, n);
+
+  error |= known_graph();
+  error |= large_values();
+  error |= threads(100);
+
+  memo_free(memo);
+  fprintf(stderr, "TEST statistics: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+/* Known answers from the Random123 test vectors (kat_vectors). */
+static int known_answers() {
+  int t, i, error = 0;
+  const unsigned long key[3][2] = {
+      {0, 0}, {0xffffffff, 0xffffffff}, {0xa4093822, 0x299f31d0}};
+  const unsigned long ctr[3][4] = {
+      {0, 0, 0, 0},
+      {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+      {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+  const unsigned long expected[3][4] = {
+      {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+      {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+      {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+
+  for (t = 0; t < 3; t++) {
+    unsigned long out[4];
+    randdag_philox(key[t], ctr[t], out);
+    for (i = 0; i < 4; i++) {
+      if (out[i] != expected[t][i]) {
+        fprintf(stderr, "[ERROR] randdag_philox: word %d of test %d is %lx "
+                        "instead of %lx\n", i, t, out[i], expected[t][i]);
+        error = 1;
+      }
+    }
+  }
+  return error;
+}
+
+/* Return 1 iff two graphs have the same vertices and edges, in the same order.
+ */
+static int same_graph(const randdag_t g, const randdag_t h) {
+  int i, j;
+  if (g.N != h.N)
+    return 0;
+  for (i = 0; i < g.N; i++) {
+    if (g.v[i].id != h.v[i].id || g.v[i].out_degree != h.v[i].out_degree)
+      return 0;
+    for (j = 0; j < g.v[i].out_degree; j++) {
+      if (g.v[i].out_edges[j].id != h.v[i].out_edges[j].id)
+        return 0;
+    }
+  }
+  return 1;
+}
+
+/* Check that the i-th sample of a run can be regenerated alone, and that
+ * different streams give different samples. */
+static int reproducibility(int nb_samples) {
+  int i, error = 0, nb_equal = 0;
+  randdag_t g[16], h;
+  gmp_randstate_t state;
+  memo_t memo = memo_alloc(20, 40, 3);
+
+  gmp_randinit_default(state);
+
+  for (i = 0; i < nb_samples; i++) {
+    randdag_seed_stream(state, 0xdeadbeef, i);
+    g[i] = doag_unif_nm(state, memo, 20, 40, 3);
+  }
+
+  for (i = nb_samples - 1; i >= 0; i--) {
+    randdag_seed_stream(state, 0xdeadbeef, i);
+    h = doag_unif_nm(state, memo, 20, 40, 3);
+    if (!same_graph(g[i], h)) {
+      fprintf(stderr, "[ERROR] sample %d could not be regenerated\n", i);
+      error = 1;
+    }
+    if (i > 0)
+      nb_equal += same_graph(g[i], g[i - 1]);
+    randdag_free(h);
+  }
+
+  if (nb_equal > 0) {
+    fprintf(stderr, "[ERROR] consecutive streams gave the same samples\n");
+    error = 1;
+  }
+
+  for (i = 0; i < nb_samples; i++)
+    randdag_free(g[i]);
+  memo_free(memo);
+  gmp_randclear(state);
+  return error;
+}
+
+int main() {
+  int error = 0;
+
+  error |= known_answers();
+  error |= reproducibility(16);
+
+  fprintf(stderr, "TEST random streams: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+
+#include "../../includes/doag.h"
+#include <gmp.h>
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Number of sources and of edges of a graph. */
+static void parameters(const randdag_t g, int *m, int *k) {
+  int i, j, l;
+
+  *m = 0;
+  *k = 0;
+  for (i = 0; i < g.N; i++) {
+    int is_source = 1;
+    *m += g.v[i].out_degree;
+    for (j = 0; j < g.N && is_source; j++) {
+      for (l = 0; l < g.v[j].out_degree; l++)
+        is_source &= (g.v[j].out_edges[l].id != g.v[i].id);
+    }
+    *k += is_source;
+  }
+}
+
+/* Sample from a window and check that:
+ * - the window's total is the sum of the counts of its parameters;
+ * - the sampled graphs have parameters within the window;
+ * - the distribution of the number of vertices is proportional to the counts.
+ */
+static int one_test(int n_lo, int n_hi, int m_lo, int m_hi, int k_lo,
+                    int k_hi, int bound, int nb_samples) {
+  int n, m, k, s, error;
+  long hits[16] = {0};
+  mpz_t sum, total;
+  memo_t memo = memo_alloc(n_hi, -1, bound);
+  window_t w = window_alloc(memo, doag_count, n_lo, n_hi, m_lo, m_hi, k_lo,
+                            k_hi, bound);
+  gmp_randstate_t state;
+
+  gmp_randinit_default(state);
+  gmp_randseed_ui(state, 0xdeadbeef);
+  mpz_init(sum);
+  mpz_init(total);
+  error = 0;
+
+  for (n = n_lo; n <= n_hi; n++) {
+    for (k = k_lo; k <= min(n, k_hi < 0 ? n : k_hi); k++) {
+      for (m = m_lo; m <= (m_hi < 0 ? n * (n - 1) / 2 : m_hi); m++)
+        mpz_add(total, total, *doag_count(memo, n, m, k, bound));
+    }
+  }
+  if (mpz_cmp(total, w.cumul[w.len - 1]) != 0) {
+    fprintf(stderr, "[ERROR] window_alloc: wrong total\n");
+    error = 1;
+  }
+
+  for (s = 0; s < nb_samples && !error; s++) {
+    randdag_t g = doag_unif_window(state, memo, w);
+    parameters(g, &m, &k);
+    if (g.N < n_lo || g.N > n_hi || m < m_lo || (m_hi >= 0 && m > m_hi) ||
+        k < k_lo || (k_hi >= 0 && k > k_hi)) {
+      fprintf(stderr, "[ERROR] doag_unif_window returned a graph with n=%d, "
+                      "m=%d, k=%d\n", g.N, m, k);
+      error = 1;
+    }
+    hits[g.N]++;
+    randdag_free(g);
+  }
+
+  for (n = n_lo; n <= n_hi && !error; n++) {
+    double expected;
+    mpz_set_ui(sum, 0);
+    for (k = k_lo; k <= min(n, k_hi < 0 ? n : k_hi); k++) {
+      for (m = m_lo; m <= (m_hi < 0 ? n * (n - 1) / 2 : m_hi); m++)
+        mpz_add(sum, sum, *doag_count(memo, n, m, k, bound));
+    }
+    expected = nb_samples * mpz_get_d(sum) / mpz_get_d(total);
+    if (hits[n] < 0.9 * expected - 10 || hits[n] > 1.1 * expected + 10) {
+      fprintf(stderr, "[ERROR] doag_unif_window returned %ld graphs of size %d "
+                      "instead of about %f\n", hits[n], n, expected);
+      error = 1;
+    }
+  }
+
+  mpz_clears(sum, total, NULL);
+  gmp_randclear(state);
+  window_free(w);
+  memo_free(memo);
+  return error;
+}
+
+int main() {
+  int error = 0;
+
+  error |= one_test(1, 6, 0, -1, 0, -1, -1, 20000);
+  error |= one_test(3, 7, 4, 6, 0, -1, 2, 20000);
+  error |= one_test(5, 8, 0, -1, 1, 2, 3, 20000);
+
+  fprintf(stderr, "TEST windows: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../includes/ldag.h"
+#include <gmp.h>
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Check that ldag_count_nk(n, k) is the sum over m of ldag_count(n, m, k). */
+static int counts(int N, int bound) {
+  int n, m, k, error;
+  mpz_t sum;
+  memo_t memo = memo_alloc(N, -1, bound);
+  memo_nk_t memo_nk = memo_nk_alloc(N, bound);
+
+  mpz_init(sum);
+  error = 0;
+
+  for (n = 0; n <= N; n++) {
+    for (k = 0; k <= n; k++) {
+      const int C = min(n - k, bound < 0 ? n : bound);
+      mpz_set_ui(sum, 0);
+      for (m = n - k; m <= C * (C - 1) / 2 + C * (n - C); m++)
+        mpz_add(sum, sum, *ldag_count(memo, n, m, k, bound));
+      if (mpz_cmp(sum, *ldag_count_nk(memo_nk, n, k, bound)) != 0) {
+        fprintf(stderr, "[ERROR] ldag_count_nk(<memo>, %d, %d, %d) returned ",
+                n, k, bound);
+        mpz_out_str(stderr, 10, *ldag_count_nk(memo_nk, n, k, bound));
+        fprintf(stderr, " instead of ");
+        mpz_out_str(stderr, 10, sum);
+        fprintf(stderr, "\n");
+        error = 1;
+      }
+    }
+  }
+
+  mpz_clear(sum);
+  memo_free(memo);
+  memo_nk_free(memo_nk);
+  return error;
+}
+
+/* --- Empirical distribution of the samplers ---------------------------- */
+
+#define MAX_CLASSES 1024
+#define KEY_LEN 64
+
+typedef struct {
+  int nb;
+  char keys[MAX_CLASSES][KEY_LEN];
+  long hits[2][MAX_CLASSES];
+} histogram;
+
+/* Return 1 iff there is a path from u to the vertex of id `id`. */
+static int reaches(const randdag_vertex *u, int id) {
+  int j;
+  for (j = 0; j < u->out_degree; j++) {
+    if (u->out_edges[j].id == id || reaches(&u->out_edges[j], id))
+      return 1;
+  }
+  return 0;
+}
+
+/* Serialise a small graph into a string: for each label in increasing order,
+ * the set of its successors. Also check that the graph is acyclic, that its
+ * labels are {0, ..., n-1} and that it has bounded out-degree. */
+static int encode(const randdag_t g, int bound, char *key) {
+  int id, i, j;
+  char succ[10];
+  char *c = key;
+
+  for (id = 0; id < g.N; id++) {
+    for (i = 0; i < g.N && g.v[i].id != id; i++) {
+    }
+    if (i == g.N || (bound >= 0 && g.v[i].out_degree > bound) ||
+        reaches(&g.v[i], id))
+      return 1;
+    memset(succ, '0', sizeof(succ));
+    for (j = 0; j < g.v[i].out_degree; j++)
+      succ[g.v[i].out_edges[j].id] = '1';
+    memcpy(c, succ, g.N);
+    c += g.N;
+  }
+  *c = '\0';
+  return 0;
+}
+
+static int record(histogram *h, int which, const randdag_t g, int bound) {
+  int i;
+  char key[KEY_LEN];
+
+  if (encode(g, bound, key))
+    return 1;
+  for (i = 0; i < h->nb && strcmp(h->keys[i], key) != 0; i++) {
+  }
+  if (i == h->nb) {
+    if (h->nb == MAX_CLASSES)
+      return 1;
+    strcpy(h->keys[i], key);
+    h->nb++;
+  }
+  h->hits[which][i]++;
+  return 0;
+}
+
+/* Compare the empirical distributions of ldag_unif_n_bounded and of
+ * ldag_unif_n using the total variation distance. */
+static int distribution(int n, int bound, long nb_samples) {
+  long s;
+  int i, error;
+  double tv;
+  histogram *h = calloc(1, sizeof(histogram));
+  memo_t memo = memo_alloc(n, -1, bound);
+  memo_nk_t memo_nk = memo_nk_alloc(n, bound);
+  gmp_randstate_t state;
+
+  gmp_randinit_default(state);
+  gmp_randseed_ui(state, 0xdeadbeef);
+  error = 0;
+
+  for (s = 0; s < nb_samples && !error; s++) {
+    randdag_t g = ldag_unif_n_bounded(state, memo_nk, n, bound);
+    error |= record(h, 0, g, bound);
+    randdag_free(g);
+    g = ldag_unif_n(state, memo, n, bound);
+    error |= record(h, 1, g, bound);
+    randdag_free(g);
+  }
+
+  if (error) {
+    fprintf(stderr, "[ERROR] ldag_unif_n_bounded(<memo>, %d, %d) returned an "
+                    "invalid graph\n",
+            n, bound);
+  } else {
+    tv = 0.;
+    for (i = 0; i < h->nb; i++) {
+      const long d = h->hits[0][i] - h->hits[1][i];
+      tv += (d < 0 ? -d : d);
+    }
+    tv = tv / (2. * nb_samples);
+    if (tv > 0.04) {
+      fprintf(stderr,
+              "[ERROR] ldag_unif_n_bounded(<memo>, %d, %d) is too far from "
+              "ldag_unif_n: total variation distance = %f\n",
+              n, bound, tv);
+      error = 1;
+    }
+  }
+
+  gmp_randclear(state);
+  memo_free(memo);
+  memo_nk_free(memo_nk);
+  free(h);
+  return error;
+}
+
+int main() {
+  int error = 0;
+
+  error |= counts(12, 0);
+  error |= counts(12, 1);
+  error |= counts(12, 2);
+  error |= counts(12, 3);
+  error |= counts(10, -1);
+  /* Around the thresholds of the machine-integer fast path. */
+  error |= counts(24, 2);
+  error |= counts(18, 3);
+  error |= counts(16, -1);
+
+  error |= distribution(3, -1, 50000);
+  error |= distribution(4, 1, 200000);
+
+  fprintf(stderr, "TEST bounded sampler: %s\n", error ? "FAILED" : "OK");
+  return error;
+}
@@ -1,4 +1,5 @@
 LDAG_TESTS = \
+	$(BUILD)tests/ldag/bounded \
 	$(BUILD)tests/ldag/forests \
 	$(BUILD)tests/ldag/small_cases \
 	$(BUILD)tests/ldag/unary_binary \
@@ -13,12 +14,16 @@ ldag-tests: $(LDAG_TESTS)
 
 $(BUILD)tests/ldag/forests: tests/ldag/forests.c $(BUILD)libldag.a
 	@mkdir -p "$(BUILD)tests/ldag"
-	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/ldag/forests.c -lldag -lgmp
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/ldag/forests.c -lldag -lgmp -lm -lpthread
 
 $(BUILD)tests/ldag/small_cases: tests/ldag/small_cases.c $(BUILD)libldag.a
 	@mkdir -p "$(BUILD)tests/ldag"
-	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/ldag/small_cases.c -lldag -lgmp
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/ldag/small_cases.c -lldag -lgmp -lm -lpthread
 
 $(BUILD)tests/ldag/unary_binary: tests/ldag/unary_binary.c $(BUILD)libldag.a
 	@mkdir -p "$(BUILD)tests/ldag"
-	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/ldag/unary_binary.c -lldag -lgmp
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/ldag/unary_binary.c -lldag -lgmp -lm -lpthread
+
+$(BUILD)tests/ldag/bounded: tests/ldag/bounded.c $(BUILD)libldag.a
+	@mkdir -p "$(BUILD)tests/ldag"
+	$(CC) $(CFLAGS) -L$(BUILD) -o $@ tests/ldag/bounded.c -lldag -lgmp -lm -lpthread